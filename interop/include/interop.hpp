@@ -8,7 +8,10 @@
 #include <thread>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
 #include <utility>
+#include <vector>
+#include <deque>
 
 namespace interop {
 
@@ -29,16 +32,85 @@ namespace interop {
 		GPU = 0, // GPU texture sharing
 		CPU = 1, // CPU texture sharing
 		MemShare = 2, // memory sharing
+		Network = 3, // packed frames streamed over a zmq socket, works across hosts
 	};
 
 	enum class ImageType {
 		LeftEye,
 		RightEye,
 		SingleStereo,
+		MultiView,
 	};
 
 	void init(Role r, DataProtocol dp = DataProtocol::TCP, ImageProtocol ip = ImageProtocol::GPU);
 
+	// settings of the ImageProtocol::Network transport, set them before initializing texture senders and receivers
+	struct NetworkImageSettings {
+		std::string address = ""; // rendering binds, steering connects. empty: port 12347 on all interfaces / localhost
+		float max_fps = 0.0f; // frames sent per second and image, 0 sends as fast as the connection drains them
+		// frames usually carry only the tiles that changed, every keyframe interval all of them
+		// so receivers that joined late or stalled for longer than that get the whole image again
+		float keyframe_interval_s = 1.0f;
+	};
+	void setNetworkImageSettings(const NetworkImageSettings& settings);
+
+	// all vectors, matrices and quaternions follow OpenGL and GLM conventions
+	// in the sense that the data can directly be passed to GL and GLM functions
+
+	// column vector, as in glm
+	struct vec4 {
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+		float w = 0.0f;
+	};
+	vec4 operator+(vec4 const& lhs, vec4 const& rhs);
+	vec4 operator+=(vec4& lhs, vec4 const& rhs);
+	vec4 operator-(vec4 const& lhs, vec4 const& rhs);
+	vec4 operator*(vec4 const& lhs, vec4 const& rhs);
+	vec4 operator*(vec4 const& v, const float s);
+	vec4 operator*(const float s, const vec4 v);
+	bool operator==(const vec4& l, const vec4& r);
+	bool operator!=(const vec4& l, const vec4& r);
+
+	// column major matrix built from column vectors: (v1, v2, v3, v4)
+	struct mat4 {
+		vec4 data[4] = {
+			vec4{1.0f, 0.0f, 0.0f, 0.0f},
+			vec4{0.0f, 1.0f, 0.0f, 0.0f},
+			vec4{0.0f, 0.0f, 1.0f, 0.0f},
+			vec4{0.0f, 0.0f, 0.0f, 1.0f},
+		};
+	};
+	vec4 operator*(const mat4& m, const vec4& v);
+	mat4 operator*(const mat4& lhs, const mat4& rhs);
+	mat4 inverse(const mat4& m); // as glm::inverse, m must be invertible
+	// world position of an image point rendered with view and projection.
+	// x, y in [0, 1] from the lower left corner of the image, depth is the window depth in [0, 1]
+	vec4 unproject(const float x, const float y, const float depth, const mat4& view, const mat4& projection);
+
+	// GL state queries (glGetIntegerv) issued and avoided by interop on the current context
+	struct GlStateStatistics {
+		uint queries_issued = 0;
+		uint queries_saved = 0;
+	};
+
+	// interop saves and restores framebuffer bindings, viewport, active texture and depth test state around its GL calls.
+	// syncGlState() reads these bindings once into a per-context cache, which our own calls keep up to date,
+	// so saving and restoring state costs no GL queries. call it once per frame, and again after the
+	// application changed any of these bindings itself. invalidateGlState() goes back to querying GL.
+	// the application invalidates the cache by calling glBindFramebuffer, glViewport, glViewportIndexed*,
+	// glActiveTexture, glEnable/glDisable(GL_DEPTH_TEST), glDepthFunc or glDepthMask itself, except
+	// framebuffer and viewport calls between glFramebuffer::bind() and unbind(), which restores the
+	// bindings saved by bind(). without a valid cache, interop queries the state it needs.
+	void syncGlState();
+	void invalidateGlState();
+	// statistics of the last frame, i.e. between the last two calls to syncGlState()
+	GlStateStatistics getGlStateStatistics();
+
+	// the textures are allocated at a capacity which may be larger than the logical size m_width x m_height.
+	// resizeTexture() within the capacity only changes the logical size, the image then occupies
+	// the lower left m_width x m_height texels of the textures.
 	struct glFramebuffer {
 		void init(uint width = 1, uint height = 1);
 		void destroy();
@@ -52,6 +124,7 @@ namespace interop {
 		uint m_glTextureRGBA8 = 0;
 		uint m_glTextureDepth = 0;
 		int m_width = 0, m_height = 0;
+		int m_capacityWidth = 0, m_capacityHeight = 0; // allocated texture size
 
 		int m_previousFramebuffer[2] = { 0 };
 		int m_previousViewport[4] = { 0 };
@@ -67,19 +140,28 @@ namespace interop {
 		bool resize(uint width, uint height);
 		void send(uint texture, uint width, uint height);
 		void send(glFramebuffer& fb);
+		uint sharedWidth(const glFramebuffer& fb) const; // size of the image send(fb) shares
+		uint sharedHeight(const glFramebuffer& fb) const;
 
 		std::string m_name = "";
 		uint m_width = 0;
 		uint m_height = 0;
 		std::shared_ptr<void> m_sender;
+		ImageProtocol m_protocol = ImageProtocol::GPU; // session protocol at init()
+	};
+
+	// how TextureReceiver::receive() hands the received image to the caller
+	enum class ReceiveMode {
+		Blit, // blit received image (y-flipped) into the framebuffer bound when calling receive()
+		Texture, // no copy, caller samples m_texture_handle directly and respects m_flip_y
 	};
 
 	struct TextureReceiver {
 		TextureReceiver();
 		~TextureReceiver();
 
-		void init(std::string name);
-		void init(ImageType type, std::string name = "");
+		void init(std::string name, ReceiveMode mode = ReceiveMode::Blit);
+		void init(ImageType type, std::string name = "", ReceiveMode mode = ReceiveMode::Blit);
 
 		void destroy();
 		bool receive();
@@ -91,16 +173,268 @@ namespace interop {
 		uint m_texture_handle = 0;
 		uint m_source_fbo = 0;
 		uint m_target_fbo = 0;
+
+		ReceiveMode m_mode = ReceiveMode::Blit;
+		// in Texture mode the image rows in m_texture_handle are stored top-down (DirectX convention).
+		// sample with v' = 1 - v, or fetch row' = m_height - 1 - row, to get the image as the sender wrote it
+		bool m_flip_y = false;
+		uint m_attached_texture = 0; // texture currently attached to m_source_fbo
+
+		ImageProtocol m_protocol = ImageProtocol::GPU; // session protocol at init()
+		// per-frame metadata of the network transport
+		uint m_frame_sequence = 0; // sender side frame counter of the received image
+		unsigned long long m_frame_send_ns = 0; // sender clock when the frame was handed to the transport
+		uint m_dropped_frames = 0; // frames skipped to get to the latest one since init()
+		uint m_frame_tiles = 0; // 64x64 tiles the latest frame changed in m_texture_handle
+	};
+
+	// how StereoTextureSender stores depth values in the RGBA8 pixels of the packed image
+	enum class DepthEncoding {
+		Float32 = 0, // raw bits of the float window depth, one value per pixel
+		Linear24 = 1, // linear depth normalized to [near, far], 24 bit unorm, four values per three pixels
+		Linear16 = 2, // linear depth normalized to [near, far], 16 bit unorm, two values per pixel (rg, ba)
+	};
+
+	// resolution of the packed depth relative to the color image.
+	// a reduced resolution sample holds the closest depth of the pixels it covers
+	enum class DepthResolution {
+		Full = 1,
+		Half = 2,
+		Quarter = 4,
+	};
+
+	// how StereoTextureSender stores color in the packed image. the block encodings compress each
+	// 4x4 block of pixels into 2 (BC1) or 4 (YCoCgDXT5) RGBA8 pixels of the packed image, the blocks
+	// are stored in row major order filling the color region pixel by pixel like depth samples.
+	// YUV420 stores bytes instead, 4 per pixel of the color region in rgba order.
+	// alpha is only kept by RGBA8
+	enum class ColorEncoding {
+		RGBA8 = 0, // one pixel per pixel
+		BC1 = 1, // BC1 block: rgb565 endpoints, 2 bit indices. 8 bytes per block, 8x smaller
+		YCoCgDXT5 = 2, // DXT5 block: Y in the alpha part, scaled Co Cg in the color part. 16 bytes per block, 4x smaller
+		YUV420 = 3, // full range BT.601 planes: Y of every pixel, then U and V of every 2x2 pixels. 1.5 bytes per pixel
+	};
+
+	// which images StereoTextureSender packs and how they are arranged
+	enum class StereoLayout {
+		ColorDepth = 0, // left | right color on top, left | right depth below
+		ColorSideBySide = 1, // left | right color in one row, no depth
+		ColorTopBottom = 2, // left color on top of right color, no depth
+		DepthOnly = 3, // left | right depth, no color
+	};
+
+	// options for packing stereo images, shared with receivers via the frame metadata
+	struct StereoPackingFormat {
+		DepthEncoding depth_encoding = DepthEncoding::Float32;
+		DepthResolution depth_resolution = DepthResolution::Full;
+		StereoLayout layout = StereoLayout::ColorDepth;
+		ColorEncoding color_encoding = ColorEncoding::RGBA8;
+
+		// single uint representation embedded in the packed image
+		uint encode() const;
+		static StereoPackingFormat decode(const uint word);
+	};
+
+	struct Rect {
+		uint x = 0;
+		uint y = 0;
+		uint width = 0;
+		uint height = 0;
+	};
+
+	// where the packed image holds which eye's color and depth.
+	// the depth region of an eye stores depth_samples_x * depth_samples_y samples in
+	// row major order, filling the pixels of the region row by row.
+	// with a block color encoding the color region is width pixels wide and as high as the blocks need
+	struct StereoPacking {
+		StereoPackingFormat format;
+		uint width = 0; // size of one eye's image
+		uint height = 0;
+		uint depth_samples_x = 0; // depth samples per eye, after resolution reduction
+		uint depth_samples_y = 0;
+		uint image_width = 0; // size of the packed image
+		uint image_height = 0;
+		uint header_rows = 0; // first rows of the packed image from y = 0, the bottom in GL, holding the FrameMetadata
+		Rect color[2]; // left, right. empty if the layout has no color
+		Rect depth[2]; // left, right. empty if the layout has no depth
+
+		bool hasColor() const;
+		bool hasDepth() const;
+
+		static StereoPacking make(const StereoPackingFormat& format, const uint width, const uint height);
+	};
+
+	// rectangles and cameras of one view in the packed image, see FrameMetadata::views_offset
+	struct ViewMetadata {
+		Rect color; // empty if the layout has no color
+		Rect depth; // empty if the layout has no depth
+		mat4 view; // the matrices the view was rendered with
+		mat4 projection;
+
+		static constexpr uint words() { return static_cast<uint>(sizeof(ViewMetadata) / sizeof(uint)); }
+	};
+	static_assert(sizeof(ViewMetadata) % sizeof(uint) == 0, "ViewMetadata must consist of 4 byte words");
+
+	// versioned description of one packed stereo image, stored in the header rows of the image.
+	// the struct is a sequence of 4 byte words, word i is the pixel (i % image_width, i / image_width)
+	// holding the uint value as r: bits 0..7, ..., a: bits 24..31.
+	// new fields are only ever appended, readers check magic and version and skip unknown fields up to views_offset.
+	// transports which do not move the image through the GPU can send the struct itself instead
+	struct FrameMetadata {
+		static constexpr uint Magic = 0x746e696d; // "mint"
+		static constexpr uint CurrentVersion = 6;
+
+		uint magic = Magic;
+		uint version = CurrentVersion;
+		uint word_count = 0; // size of the header in 4 byte words, this struct followed by the view table
+		uint steering_frame_id = 0; // meta_data passed to send()
+		uint user_data = 0; // meta_data_2 passed to send()
+		uint frame_sequence = 0; // counts the frames of the sender
+		uint format = 0; // StereoPackingFormat::encode()
+		uint header_rows = 0;
+		uint eye_width = 0;
+		uint eye_height = 0;
+		float depth_near = 0.0f; // clip planes used for the linear depth encodings
+		float depth_far = 0.0f;
+		unsigned long long render_start_ns = 0; // high resolution clock of the renderer, since epoch
+		unsigned long long render_end_ns = 0;
+		Rect color[2]; // left, right, in the packed image
+		Rect depth[2];
+		mat4 view[2]; // left, right, the matrices the images were rendered with
+		mat4 projection[2];
+		// version 2
+		uint view_count = 0; // entries of the ViewMetadata table in the header
+		uint views_offset = 0; // word index of the table, it follows this struct
+		// version 3
+		// foveated packing if > 1: the packed eye images of eye_width x eye_height hold the whole eye
+		// downsampled by periphery_scale, padded to the full resolution inset at their right end, see Foveation
+		uint periphery_scale = 0;
+		uint full_eye_width = 0; // size of the eye images before foveated packing
+		uint full_eye_height = 0;
+		Rect inset[2]; // left, right, full resolution region of the eye images in texels
+		// version 4
+		// resolution the eye images were rendered at relative to the requested image size, see DynamicResolution.
+		// receivers stretch them to the requested size
+		float render_scale = 1.0f;
+		// version 5
+		// progressive refinement: the renderer restarts at level 0 when the camera moves and refines the image
+		// by one level per frame while it stays. final at refinement_levels - 1, 0 levels if not progressive.
+		// lower levels come stretched to the size of the final one, render_scale tells their resolution
+		uint refinement_level = 0;
+		uint refinement_levels = 0;
+		// version 6
+		// how far the cameras were extrapolated past the newest received pose, see PosePredictor
+		float prediction_ms = 0.0f;
+
+		static constexpr uint words() { return static_cast<uint>(sizeof(FrameMetadata) / sizeof(uint)); }
+		// words of the header rows including the view table
+		static constexpr uint words(const uint view_count) { return words() + view_count * ViewMetadata::words(); }
+	};
+	static_assert(sizeof(FrameMetadata) % sizeof(uint) == 0, "FrameMetadata must consist of 4 byte words");
+
+	// foveated packing of StereoTextureSender: each eye is reduced to a full resolution inset around
+	// the gaze point next to the whole eye downsampled by periphery_scale (box filtered color, closest depth)
+	// before packing. StereoTextureReceiver upsamples the periphery and puts the inset back on top
+	struct Foveation {
+		uint periphery_scale = 1; // 1 packs the eyes as they are
+		float inset_size = 1.0f / 3.0f; // of the eye width and height
+		float gaze_x[2] = { 0.5f, 0.5f }; // left, right, center of the inset in [0, 1] of the eye images
+		float gaze_y[2] = { 0.5f, 0.5f };
+	};
+
+	// how StereoTextureSender writes the packed image
+	enum class PackingPath {
+		Auto = 0, // Compute if the context supports GL 4.3, Fragment otherwise
+		Fragment = 1, // draw covering the packed regions of the image
+		Compute = 2, // compute pass storing each region of the packed image, without clearing it first
+	};
+
+	// writes the color and depth textures of up to two views into their regions of a packed image.
+	// regions with zero width are skipped and pixels outside the regions are left untouched,
+	// so several pack() calls can fill one image
+	struct ImagePacker {
+		void init(const StereoLayout layout);
+		void destroy();
+		// recompiles the shaders if the layout changed
+		void setLayout(const StereoLayout layout);
+		void setPath(const PackingPath path);
+		void pack(glFramebuffer& target, const StereoPacking& regions,
+			const uint color_textures[2], const uint depth_textures[2],
+			const float depth_near, const float depth_far);
+		// only encodes depth of both views rendered into one depth texture, view i at the origin of
+		// depth_sources[i]. the color regions of target are left untouched
+		void packDepth(glFramebuffer& target, const StereoPacking& regions, const uint depth_texture,
+			const Rect depth_sources[2], const float depth_near, const float depth_far);
+		// GPU time between beginTimer() and endTimer() in ms of the latest frame whose timer query finished,
+		// which lags a few frames. negative until the first result arrived
+		void beginTimer();
+		void endTimer();
+		float getGpuMs() const;
+
+		StereoLayout m_layout = StereoLayout::ColorDepth; // layout the shaders were compiled for
+		uint m_shader = 0;
+		uint m_vao = 0;
+		uint m_uniform_locations[15] = { 0 };
+		PackingPath m_path = PackingPath::Auto;
+		bool m_useCompute = false; // m_path resolved against the context
+		uint m_computeShader = 0; // 0 if the context does not support compute shaders
+		uint m_compute_uniform_locations[16] = { 0 };
+		// copy the color regions with glCopyImageSubData (GL 4.3) instead of packing them in the shader.
+		// only used if the color textures are RGBA8 like the packed image
+		bool m_copyColor = true;
+		bool m_copyImageAvailable = false;
+		std::unordered_map<uint, bool> m_copyableTextures; // color textures whose format was checked for copying
+		static constexpr uint timer_queries = 4;
+		uint m_timerQueries[timer_queries] = { 0 };
+		uint m_timerQueryIndex = 0;
+		float m_gpuMs = -1.0f;
+		uint m_gpuResults = 0; // timer query results read into m_gpuMs so far, tells a new result from a repeated one
+		void selectPath();
+		void bindInputs(const uint* uniform_locations, const StereoPacking& regions,
+			const uint color_textures[2], const uint depth_textures[2], const Rect depth_sources[2],
+			const float depth_near, const float depth_far);
+		void draw(glFramebuffer& target, const StereoPacking& regions,
+			const uint color_textures[2], const uint depth_textures[2], const Rect depth_sources[2],
+			const float depth_near, const float depth_far, const bool skip_color);
+		void dispatch(glFramebuffer& target, const StereoPacking& regions,
+			const uint color_textures[2], const uint depth_textures[2], const Rect depth_sources[2],
+			const float depth_near, const float depth_far, const bool skip_color);
+		bool canCopyColor(const StereoPacking& regions, const uint color_textures[2]);
+		void copyColor(glFramebuffer& target, const StereoPacking& regions, const uint color_textures[2]);
 	};
 
 	// packs color and depth textures into one huge texture before sharing texture
 	// data with other processes input widht/height are for the original size of the
-	// input textures
+	// input textures.
+	// the packed image starts with header rows holding the FrameMetadata of the frame
 	struct StereoTextureSender {
 		StereoTextureSender();
 		~StereoTextureSender();
 
-		void init(std::string name = "", const uint width = 1, const uint height = 1);
+		void init(std::string name = "", const uint width = 1, const uint height = 1,
+			const StereoPackingFormat format = StereoPackingFormat{});
+		void setPackingFormat(const StereoPackingFormat format);
+		// clip planes of the projection the depth was rendered with, needed for the linear depth encodings
+		void setDepthRange(const float near_plane, const float far_plane);
+		// cameras and render start time of the next frame to send, recorded in its FrameMetadata
+		void setFrameCameras(const mat4& view_left, const mat4& projection_left,
+			const mat4& view_right, const mat4& projection_right);
+		void setRenderStart(const unsigned long long render_start_ns);
+		// resolution the next frames are rendered at relative to the requested image size, recorded in their FrameMetadata
+		void setRenderScale(const float render_scale);
+		// refinement level of the next frames out of levels, see FrameMetadata::refinement_level
+		void setRefinement(const uint level, const uint levels);
+		// of the cameras of the next frames, see FrameMetadata::prediction_ms
+		void setPredictionHorizon(const float prediction_ms);
+		void setPackingPath(const PackingPath path);
+		// the gaze point may change every frame, the size of the packed image only with scale and inset size.
+		// rendering in place needs it off
+		void setFoveation(const Foveation& foveation);
+		// GPU time in ms of packing the latest frame whose timer query finished, which lags a few frames.
+		// negative until the first result arrived
+		float getPackGpuMs() const;
+		// frames which had to wait because their packed image was still being shared or read back
+		uint getTargetWaits() const;
 
 		void destroy();
 		void send(glFramebuffer& fb_left, glFramebuffer& fb_right,
@@ -110,28 +444,292 @@ namespace interop {
 			const uint depth_left, const uint depth_right,
 			const uint width, const uint height,
 			const uint meta_data = 0, const uint meta_data_2 = 0);
+		// single pass stereo rendering straight into the packed image: the caller renders both eyes
+		// into the returned framebuffer at the color regions of m_packing, then sendInPlace() only
+		// encodes the depth rendered there and writes the header. needs a layout with RGBA8 color.
+		// the framebuffer changes from frame to frame
+		glFramebuffer& beginRenderInPlace(const uint width, const uint height);
+		void sendInPlace(const uint meta_data = 0, const uint meta_data_2 = 0);
+		// peak signal to noise ratio in dB of the packed color of the latest frame against the left color
+		// texture it was packed from, or its foveated image. reads both back, meant for benchmarks.
+		// infinite for lossless color
+		float measureColorPsnr(const uint color_left);
 
 		std::string m_name = "";
 		uint m_width = 0;
 		uint m_height = 0;
 		uint m_hugeWidth = 0;
 		uint m_hugeHeight = 0;
-		glFramebuffer
-			m_hugeFbo; // holds huge texture for sending 2x color, 2x depth at once
+		StereoPackingFormat m_format;
+		StereoPacking m_packing; // of the foveated eye images if foveated
+		Foveation m_foveation;
+		Rect m_insets[2]; // of the next frame, in the eye images
+		glFramebuffer m_foveatedFbos[2]; // left, right. eye images reduced by the foveation pass
+		uint m_foveationShader = 0;
+		uint m_foveation_uniform_locations[6] = { 0 };
+		float m_depthNear = 0.1f;
+		float m_depthFar = 1.0f;
+		mat4 m_view[2]; // set by setFrameCameras()
+		mat4 m_projection[2];
+		unsigned long long m_renderStartNs = 0;
+		float m_renderScale = 1.0f;
+		uint m_refinementLevel = 0;
+		uint m_refinementLevels = 0;
+		float m_predictionMs = 0.0f;
+		FrameMetadata m_metadata; // of the last frame sent
+		std::vector<uint> m_headerPixels; // header rows uploaded into the packed image
+		// ring of huge textures for sending 2x color, 2x depth at once. the next frame is packed
+		// into one target while the GPU still copies the previous one out of the other
+		static constexpr uint packed_targets = 2;
+		glFramebuffer m_hugeFbos[packed_targets];
+		void* m_targetFences[packed_targets] = { nullptr }; // GLsync, signaled once the target was shared or read back
+		uint m_target = 0; // index of the target the next frame is packed into
+		uint m_targetWaits = 0;
 		TextureSender m_hugeTextureSender;
+		ImagePacker m_packer;
 		void makeHugeTexture(const uint originalWidth, const uint originalHeight);
+		bool isFoveated() const;
+		void foveate(const uint color_textures[2], const uint depth_textures[2]);
+		void writeHeader(glFramebuffer& target, const uint meta_data, const uint meta_data_2);
+		glFramebuffer& acquireTarget(); // waits till the current target may be packed again
+		void releaseTarget(); // shares the current target and moves on to the next
+
+		static_assert(sizeof(uint) == 4, "unigned int expected to be 4 bytes");
+	};
+
+	// where the packed image of MultiViewTextureSender holds the color and depth of each view.
+	// views are tiles of a grid with columns = ceil(sqrt(view_count)), filled row by row,
+	// a tile holds the color of the view with its depth below, stored like in StereoPacking.
+	// StereoLayout selects the content of the tiles: ColorSideBySide and ColorTopBottom mean color only
+	struct MultiViewPacking {
+		StereoPackingFormat format;
+		uint view_count = 0;
+		uint width = 0; // size of one view's image
+		uint height = 0;
+		uint depth_samples_x = 0; // depth samples per view, after resolution reduction
+		uint depth_samples_y = 0;
+		uint columns = 0; // tiles of the grid
+		uint rows = 0;
+		uint image_width = 0; // size of the packed image
+		uint image_height = 0;
+		uint header_rows = 0; // first rows of the packed image from y = 0, the bottom in GL, holding the FrameMetadata and view table
+		std::vector<Rect> color; // per view, empty rects if the layout has no color
+		std::vector<Rect> depth;
+
+		// regions of the views first_view and first_view + 1, the second one is empty if it does not exist
+		StereoPacking pair(const uint first_view) const;
+
+		static MultiViewPacking make(const StereoPackingFormat& format, const uint view_count,
+			const uint width, const uint height);
+	};
+
+	// packs the color and depth of any number of views, e.g. the faces of a cube map or the eyes of
+	// several users, into one atlas which is shared as a single texture.
+	// the header rows hold the FrameMetadata followed by a ViewMetadata per view.
+	// the eye fields of FrameMetadata describe views 0 and 1
+	struct MultiViewTextureSender {
+		void init(std::string name = "", const uint view_count = 1, const uint width = 1, const uint height = 1,
+			const StereoPackingFormat format = StereoPackingFormat{});
+		void destroy();
+		void setPackingFormat(const StereoPackingFormat format);
+		void setViewCount(const uint view_count);
+		// clip planes of the projections the depth was rendered with, needed for the linear depth encodings
+		void setDepthRange(const float near_plane, const float far_plane);
+		// camera of a view of the next frame to send, recorded in its metadata
+		void setViewCamera(const uint view, const mat4& view_matrix, const mat4& projection);
+		void setRenderStart(const unsigned long long render_start_ns);
+		void setPackingPath(const PackingPath path);
+		// see StereoTextureSender::getPackGpuMs()
+		float getPackGpuMs() const;
+
+		// one texture per view, all of size width x height. depth textures may be 0 if the layout has no depth
+		void send(const std::vector<uint>& color_textures, const std::vector<uint>& depth_textures,
+			const uint width, const uint height,
+			const uint meta_data = 0, const uint meta_data_2 = 0);
+		void send(const std::vector<glFramebuffer*>& views, const uint width, const uint height,
+			const uint meta_data = 0, const uint meta_data_2 = 0);
+
+		uint m_width = 0;
+		uint m_height = 0;
+		StereoPackingFormat m_format;
+		MultiViewPacking m_packing;
+		float m_depthNear = 0.1f;
+		float m_depthFar = 1.0f;
+		std::vector<ViewMetadata> m_views; // cameras set by setViewCamera(), rects of the last frame sent
+		unsigned long long m_renderStartNs = 0;
+		FrameMetadata m_metadata; // of the last frame sent
+		std::vector<uint> m_headerPixels;
+		glFramebuffer m_atlasFbo;
+		TextureSender m_atlasSender;
+		ImagePacker m_packer;
+		void makeAtlas(const uint view_count, const uint width, const uint height);
+		void writeHeader(const uint meta_data, const uint meta_data_2);
+	};
+
+	// receives the packed image of StereoTextureSender and unpacks it on the GPU into per eye color
+	// textures and GL_DEPTH_COMPONENT32F depth textures holding window depth, whichever DepthEncoding
+	// the sender used. the unpack pass reads the rects and format from the header rows of the image itself.
+	// foveated images are unpacked into eye images of the packed size first and then reconstructed at full size.
+	// with ImageType::MultiView it receives the atlas of MultiViewTextureSender, views m_firstView and
+	// m_firstView + 1 of its view table are unpacked as left and right
+	struct StereoTextureReceiver {
+		void init(std::string name = "", const ImageType type = ImageType::SingleStereo);
+		void destroy();
+		// false if no new image arrived or it has no valid header. the textures keep the last unpacked frame
+		bool receive();
+		// whether the header has a view for the eye, 0 = left, 1 = right
+		bool hasEye(const uint eye) const;
+		// rects and cameras of the eye, from the view table or the eye fields of m_metadata
+		ViewMetadata eyeView(const uint eye) const;
+
+		TextureReceiver m_receiver; // packed image in Texture mode
+		// header of the packed image, read back asynchronously. it lags one receive() behind the textures,
+		// except after the packed image changed its size. frame_sequence tells the frame it belongs to.
+		// the unpack pass checks the header of the current frame itself: a frame needing other eye images
+		// than the ones allocated from this header is not unpacked, the textures keep the previous frame
+		FrameMetadata m_metadata;
+		// read the header of every frame synchronously, so m_metadata always belongs to the textures.
+		// for users of the cameras of the unpacked frame on the CPU, costs a wait for the GPU per frame
+		bool m_syncHeader = false;
+		std::vector<ViewMetadata> m_views; // view table of m_metadata
+		uint m_firstView = 0; // view unpacked as the left eye. eyes without a view keep their textures
+		StereoPacking m_packing; // the textures are allocated for, made from m_metadata. of the full size eyes if foveated
+		uint m_colorTextures[2] = { 0 }; // left, right. eye_width x eye_height RGBA8, rows bottom-up
+		uint m_depthTextures[2] = { 0 }; // depth_samples_x x depth_samples_y DEPTH_COMPONENT32F
+		uint m_colorFbos[2] = { 0 };
+		uint m_depthFbos[2] = { 0 };
+		// left, right. the BC1 or DXT5 blocks of the color regions, uploaded as they are when the packed
+		// image arrived over the network and the GL decodes S3TC. the unpack pass decodes them otherwise
+		uint m_blockTextures[2] = { 0 };
+		bool m_blockUpload = false; // GL_EXT_texture_compression_s3tc
+		bool m_blocksUploaded = false; // of the current frame
+		StereoPacking m_foveatedPacking; // of the packed image if it is foveated, zero width otherwise
+		uint m_foveatedColorTextures[2] = { 0 }; // like the textures above, at the size of m_foveatedPacking
+		uint m_foveatedDepthTextures[2] = { 0 };
+		uint m_foveatedColorFbos[2] = { 0 };
+		uint m_foveatedDepthFbos[2] = { 0 };
+		uint m_packedFbo = 0; // reads the header rows of the packed image
+		uint m_attachedTexture = 0;
+		uint m_packedWidth = 0;
+		uint m_packedHeight = 0;
+		uint m_headerPbo = 0;
+		uint m_headerPboRows = 0; // rows of the pending read, 0 if none
+		bool m_headerPboFlipped = false;
+		std::vector<uint> m_headerPixels;
 		uint m_shader = 0;
 		uint m_vao = 0;
-		uint m_uniform_locations[7] = { 0 };
-		void initGLresources();
-		void destroyGLresources();
-		void blitTextures(const uint color_left_texture,
-			const uint color_right_texture,
-			const uint depth_left_texture,
-			const uint depth_right_texture, const uint width,
-			const uint height, const uint meta_data, const uint meta_data_2 = 0);
+		uint m_uniform_locations[8] = { 0 };
+		uint m_reconstructShader = 0;
+		uint m_reconstruct_uniform_locations[8] = { 0 };
+		void readHeader();
+		void parseHeader(const uint* pixels, const uint rows, const bool flipped);
+		void makeTextures();
+		void deleteTextures();
+		bool uploadBlocks();
+		void unpack();
+		void reconstruct();
+	};
 
-		static_assert(sizeof(uint) == 4, "unigned int expected to be 4 bytes");
+	// world positions under pixels of the latest frame of a StereoTextureReceiver, taken from its
+	// unpacked depth and the cameras in the header rows of the same frame, or of a framebuffer with depth.
+	// the readback is asynchronous, requests are answered by a later poll() without waiting for the GPU
+	struct DepthPicker {
+		struct Pick {
+			uint id = 0; // returned by request()
+			uint eye = 0; // 0 = left, 1 = right
+			uint x = 0; // pixel of the eye image, from the lower left corner
+			uint y = 0;
+			bool hit = false; // false if the region only holds the far plane or the frame had no depth
+			float depth = 1.0f; // closest window depth of the region
+			vec4 world; // position of the closest depth sample, w = 1
+			uint frame_sequence = 0; // FrameMetadata::frame_sequence of the frame the depth was taken from
+		};
+
+		void init();
+		void destroy();
+		// picks the closest depth within radius pixels around (x, y) of the eye image. 0 if the receiver
+		// has no unpacked depth yet
+		uint request(const StereoTextureReceiver& receiver, const uint eye, const uint x, const uint y,
+			const uint radius = 0);
+		// picks from the depth attachment of fbo within viewport instead, e.g. of an image the application
+		// reprojected to the camera view, projection. (x, y) are relative to the viewport, eye and
+		// frame_sequence are only passed on to the Pick. 0 if fbo has no depth
+		uint request(const glFramebuffer& fbo, const Rect& viewport, const uint eye, const uint x, const uint y,
+			const mat4& view, const mat4& projection, const uint radius = 0, const uint frame_sequence = 0);
+		// picks whose readback finished, in request order
+		std::vector<Pick> poll();
+
+		struct PendingPick {
+			Pick pick;
+			uint buffer = 0; // header rows followed by the depth samples of the region
+			uint view = 0; // of the view table, whose camera unprojects the pick
+			mat4 view_matrix; // camera of picks without header rows
+			mat4 projection;
+			void* fence = nullptr;
+			uint header_width = 0; // pixels per header row
+			uint header_rows = 0; // 0 for picks from a framebuffer
+			bool header_flipped = false;
+			uint samples_x = 0; // region of the depth texture
+			uint samples_y = 0;
+			uint region_x = 0;
+			uint region_y = 0;
+			uint region_width = 0;
+			uint region_height = 0;
+		};
+		std::vector<PendingPick> m_pending;
+		std::vector<uint> m_freeBuffers; // pixel pack buffers of finished picks, reused by later requests
+		uint m_nextId = 1;
+	};
+
+	// keeps the frame time of a renderer at a target by scaling its render resolution.
+	// beginFrame() and endFrame() enclose rendering and sending a frame. its GPU time comes from timestamp
+	// queries read a few frames later without waiting, its CPU time from the clock. the slower of both
+	// drives the scale, which changes in steps and only after settling, so render targets are not resized every frame
+	struct DynamicResolution {
+		void init(const float target_ms, const float min_scale = 0.5f, const float max_scale = 1.0f);
+		void destroy();
+		void beginFrame();
+		void endFrame();
+		// of width and height, changes only in endFrame()
+		float getScale() const;
+		// size scaled by getScale(), at least 1
+		uint scaled(const uint size) const;
+
+		float m_targetMs = 0.0f;
+		float m_minScale = 0.5f;
+		float m_maxScale = 1.0f;
+		float m_scale = 1.0f;
+		float m_frameMs = -1.0f; // smoothed frame time at the current scale, negative until measured
+		float m_gpuMs = -1.0f; // of the latest frame at the current scale whose queries finished
+		float m_cpuMs = 0.0f; // of the latest frame
+		uint m_framesAtScale = 0; // measured since the scale changed
+		unsigned long long m_frameStartNs = 0;
+		static constexpr uint timer_queries = 4;
+		uint m_timerQueries[2 * timer_queries] = { 0 }; // start and end timestamp of each frame
+		float m_queryScales[timer_queries] = { 0.0f }; // scale each frame was rendered at
+		uint m_timerQueryIndex = 0;
+		void update(const float frame_ms);
+	};
+
+	// credit based flow control between a renderer and its display. the display acknowledges the
+	// FrameMetadata::frame_sequence of the frames it showed, the renderer holds back new frames while
+	// max_in_flight are sent beyond the last acknowledged one. without acknowledgements, or after the
+	// timeout without a new one, frames are not held back, so a display that does not acknowledge never stalls it
+	struct FrameCredits {
+		void init(const uint max_in_flight, const uint timeout_ms = 1000);
+		// frame_sequence of the frame just sent
+		void sent(const uint frame_sequence);
+		// latest frame the display showed and how many frames it never showed so far, older frames are ignored
+		void acknowledge(const uint frame_sequence, const uint dropped_frames = 0);
+		uint inFlight() const;
+		bool canSend() const;
+
+		uint m_maxInFlight = 0; // 0 for no limit
+		unsigned long long m_timeoutNs = 0;
+		uint m_sent = 0;
+		uint m_acknowledged = 0;
+		unsigned long long m_acknowledgedNs = 0; // when m_acknowledged changed, 0 before the first acknowledgement
+		uint m_droppedFrames = 0; // as counted by the display
 	};
 
 	enum class Endpoint {
@@ -148,6 +746,10 @@ namespace interop {
 		void stop();
 
 		bool send_raw(std::string const& v, std::string const& filterName);
+		// adds the send time to the structured messages of filterName, for DataReceiver::history().
+		// other topics keep their format, receivers like Unity do not expect the field
+		void stampSendTime(const std::string& filterName);
+		bool stampsSendTime(const std::string& filterName) const;
 
 		template <typename DataType>
 		bool send(DataType const& v);
@@ -157,6 +759,16 @@ namespace interop {
 
 		std::shared_ptr<void> m_sender;
 		std::string m_address;
+		std::vector<std::string> m_stampedTopics;
+	};
+
+	// a message kept by DataReceiver::keepHistory()
+	struct TimedMessage {
+		unsigned long long receive_ns = 0; // high resolution clock of the receiver, since epoch
+		unsigned long long send_ns = 0; // clock of the sender, 0 if the sender did not stamp the message
+		unsigned long long time_ns = 0; // send_ns on the receiver clock, receive_ns for unstamped messages
+		std::string content;
+		std::shared_ptr<const void> parsed; // content as nlohmann::json, parsed once on arrival. null if it is no json
 	};
 
 	struct DataReceiver {
@@ -171,6 +783,18 @@ namespace interop {
 		template <typename Datatype> bool receive(Datatype& v, const std::string& filterName);
 		template <typename Datatype> bool receive(Datatype& v, const std::string& filterName, std::optional<std::pair<std::string/*name*/, std::string/*value*/>>& maybe_extra);
 		std::optional<std::string> receiveCopy(const std::string& filterName = "");
+		// blocks until a message whose content differs from the previous one of its topic arrived since the last wait,
+		// or the timeout passed. returns whether one arrived
+		bool wait(const uint timeout_ms);
+		// a field of the messages of filterName, as json pointer, that changes with every send and is no change
+		// of content for wait(), e.g. a frame id. the send time stamp never is
+		void ignoreOnWait(const std::string& filterName, const std::string& field);
+		// keeps the last samples messages of filterName with the time they were sent, if the sender stamps them
+		// with DataSender::stampSendTime()
+		void keepHistory(const std::string& filterName, const uint samples);
+		// oldest first. the sender clock is moved to the receiver clock by the smallest delay seen on the topic in the
+		// last seconds, which takes the transport latency out of the message times but not their spacing
+		std::vector<TimedMessage> history(const std::string& filterName);
 
 		//std::shared_ptr<void> m_receiver;
 		std::string m_filterName;
@@ -182,35 +806,21 @@ namespace interop {
 
 		std::unordered_map<std::string, std::string> m_messages;
 		std::mutex m_mutex;
-	};
-
-	// all vectors, matrices and quaternions follow OpenGL and GLM conventions
-	// in the sense that the data can directly be passed to GL and GLM functions
-
-	// column vector, as in glm
-	struct vec4 {
-		float x = 0.0f;
-		float y = 0.0f;
-		float z = 0.0f;
-		float w = 0.0f;
-	};
-	vec4 operator+(vec4 const& lhs, vec4 const& rhs);
-	vec4 operator+=(vec4& lhs, vec4 const& rhs);
-	vec4 operator-(vec4 const& lhs, vec4 const& rhs);
-	vec4 operator*(vec4 const& lhs, vec4 const& rhs);
-	vec4 operator*(vec4 const& v, const float s);
-	vec4 operator*(const float s, const vec4 v);
-	bool operator==(const vec4& l, const vec4& r);
-	bool operator!=(const vec4& l, const vec4& r);
-
-	// column major matrix built from column vectors: (v1, v2, v3, v4)
-	struct mat4 {
-		vec4 data[4] = {
-			vec4{1.0f, 0.0f, 0.0f, 0.0f},
-			vec4{0.0f, 1.0f, 0.0f, 0.0f},
-			vec4{0.0f, 0.0f, 1.0f, 0.0f},
-			vec4{0.0f, 0.0f, 0.0f, 1.0f},
+		std::condition_variable m_messageArrived;
+		unsigned long long m_changedCount = 0; // messages with changed content
+		unsigned long long m_waitedCount = 0;
+		bool m_waitUsed = false; // contents are only compared once wait() was called
+		std::unordered_map<std::string, std::vector<std::string>> m_waitIgnored;
+		std::unordered_map<std::string, std::string> m_waitContents; // last content of each topic, as wait() compares it
+		std::unordered_map<std::string, uint> m_historySamples;
+		std::unordered_map<std::string, std::deque<TimedMessage>> m_history;
+		// smallest receive_ns - send_ns of a topic in the current and the previous window of a few seconds
+		struct ClockOffset {
+			long long current = 0;
+			long long previous = 0;
+			unsigned long long window_start_ns = 0;
 		};
+		std::unordered_map<std::string, ClockOffset> m_clockOffsets;
 	};
 
 	struct CameraView {
@@ -370,6 +980,29 @@ namespace interop {
 	template <typename DataType>
 	std::string to_data_name(DataType const& v);
 
+	// extrapolates the camera poses of a topic to the time a frame will be displayed, from the last poses
+	// the DataReceiver kept with their send time, see DataSender::stampSendTime(). constant velocity uses the
+	// last two poses, constant acceleration the last three. positions are extrapolated linearly, rotations
+	// as quaternions. when the poses stop arriving the prediction fades back to the newest one
+	struct PosePredictor {
+		enum class Model {
+			ConstantVelocity,
+			ConstantAcceleration,
+		};
+
+		void init(DataReceiver& receiver, const std::string& topic, const Model model = Model::ConstantVelocity, const float max_horizon_ms = 100.0f);
+		// newest pose extrapolated to target_ns, high resolution clock of the receiver since epoch.
+		// eyePos.w is kept from the newest pose. false before the first pose arrived
+		bool predict(const unsigned long long target_ns, StereoCameraViewRelative& pose);
+		bool predict(const unsigned long long target_ns, CameraView& pose);
+
+		DataReceiver* m_receiver = nullptr;
+		std::string m_topic;
+		Model m_model = Model::ConstantVelocity;
+		float m_maxHorizonMs = 100.0f; // extrapolated no further past the newest pose
+		float m_horizonMs = 0.0f; // of the last prediction, from the newest pose to the target
+	};
+
 } // namespace interop
 
 namespace mint = interop;
@@ -6,6 +6,12 @@
 #include <zmq.hpp>
 
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <condition_variable>
 
 using json = nlohmann::json;
 
@@ -34,6 +40,71 @@ namespace {
 #define GL_TEXTURE0 0x84C0
 #define GL_ACTIVE_TEXTURE 0x84E0
 #define GL_DEPTH_COMPONENT32 0x81A7
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_MAJOR_VERSION
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MINOR_VERSION 0x821C
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_PIXEL_BUFFER_BARRIER_BIT 0x00000080
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_READ_WRITE
+#define GL_READ_WRITE 0x88BA
+#endif
+#ifndef GL_R32UI
+#define GL_R32UI 0x8236
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_TEXTURE_INTERNAL_FORMAT
+#define GL_TEXTURE_INTERNAL_FORMAT 0x1003
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_DEPTH_COMPONENT32F
+#define GL_DEPTH_COMPONENT32F 0x8CAC
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_NUM_EXTENSIONS
+#define GL_NUM_EXTENSIONS 0x821D
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
 	// MAKE_GL_CALL(glDrawBuffersEXT, void, GLsizei n, const GLenum *bufs)
 	MAKE_GL_CALL(glCreateShader, GLuint, GLenum shaderType)
 		MAKE_GL_CALL(glShaderSource, void, GLuint shader, GLsizei count,
@@ -58,8 +129,39 @@ namespace {
 		// MAKE_GL_CALL(glBindTexture, void, GLenum target, GLuint texture)
 		MAKE_GL_CALL(glUniform1i, void, GLint location, GLint v0)
 		MAKE_GL_CALL(glUniform2i, void, GLint location, GLint v0, GLint v1)
+		MAKE_GL_CALL(glUniform2f, void, GLint location, GLfloat v0, GLfloat v1)
+		MAKE_GL_CALL(glUniform4i, void, GLint location, GLint v0, GLint v1, GLint v2, GLint v3)
+		MAKE_GL_CALL(glDispatchCompute, void, GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z)
+		MAKE_GL_CALL(glBindImageTexture, void, GLuint unit, GLuint texture, GLint level, GLboolean layered,
+			GLint layer, GLenum access, GLenum format)
+		MAKE_GL_CALL(glMemoryBarrier, void, GLbitfield barriers)
+		MAKE_GL_CALL(glCopyImageSubData, void, GLuint srcName, GLenum srcTarget, GLint srcLevel,
+			GLint srcX, GLint srcY, GLint srcZ, GLuint dstName, GLenum dstTarget, GLint dstLevel,
+			GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth)
+		MAKE_GL_CALL(glGenQueries, void, GLsizei n, GLuint* ids)
+		MAKE_GL_CALL(glDeleteQueries, void, GLsizei n, const GLuint* ids)
+		MAKE_GL_CALL(glBeginQuery, void, GLenum target, GLuint id)
+		MAKE_GL_CALL(glEndQuery, void, GLenum target)
+		MAKE_GL_CALL(glGetQueryObjectiv, void, GLuint id, GLenum pname, GLint* params)
+		MAKE_GL_CALL(glGetQueryObjectui64v, void, GLuint id, GLenum pname, unsigned long long* params)
+		MAKE_GL_CALL(glQueryCounter, void, GLuint id, GLenum target)
+		MAKE_GL_CALL(glGenBuffers, void, GLsizei n, GLuint* buffers)
+		MAKE_GL_CALL(glDeleteBuffers, void, GLsizei n, const GLuint* buffers)
+		MAKE_GL_CALL(glBufferData, void, GLenum target, ptrdiff_t size, const void* data, GLenum usage)
+		MAKE_GL_CALL(glBufferSubData, void, GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data)
+		MAKE_GL_CALL(glBindBufferBase, void, GLenum target, GLuint index, GLuint buffer)
+		MAKE_GL_CALL(glMapBufferRange, void*, GLenum target, ptrdiff_t offset, ptrdiff_t length, GLbitfield access)
+		MAKE_GL_CALL(glUnmapBuffer, GLboolean, GLenum target)
+		MAKE_GL_CALL(glFenceSync, void*, GLenum condition, GLbitfield flags)
+		MAKE_GL_CALL(glClientWaitSync, GLenum, void* sync, GLbitfield flags, unsigned long long timeout)
+		MAKE_GL_CALL(glDeleteSync, void, void* sync)
 		MAKE_GL_CALL(glCopyTexSubImage2D, void, GLenum, GLint, GLint, GLint, GLint,
 			GLint, GLsizei, GLsizei)
+		MAKE_GL_CALL(glTexStorage2D, void, GLenum target, GLsizei levels, GLenum internalformat,
+			GLsizei width, GLsizei height)
+		MAKE_GL_CALL(glCompressedTexSubImage2D, void, GLenum target, GLint level, GLint xoffset, GLint yoffset,
+			GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data)
+		MAKE_GL_CALL(glGetStringi, const GLubyte*, GLenum name, GLuint index)
 
 		MAKE_GL_CALL(glGenFramebuffersEXT, void, GLsizei n, GLuint* ids)
 		MAKE_GL_CALL(glBindFramebufferEXT, void, GLenum target, GLuint framebuffer)
@@ -109,7 +211,33 @@ namespace {
 			// GET_GL_CALL(glBindTexture)
 			GET_GL_CALL(glUniform1i)
 			GET_GL_CALL(glUniform2i)
+			GET_GL_CALL(glUniform2f)
+			GET_GL_CALL(glUniform4i)
+			GET_GL_CALL(glDispatchCompute)
+			GET_GL_CALL(glBindImageTexture)
+			GET_GL_CALL(glMemoryBarrier)
+			GET_GL_CALL(glCopyImageSubData)
+			GET_GL_CALL(glGenQueries)
+			GET_GL_CALL(glDeleteQueries)
+			GET_GL_CALL(glBeginQuery)
+			GET_GL_CALL(glEndQuery)
+			GET_GL_CALL(glGetQueryObjectiv)
+			GET_GL_CALL(glGetQueryObjectui64v)
+			GET_GL_CALL(glQueryCounter)
+			GET_GL_CALL(glGenBuffers)
+			GET_GL_CALL(glDeleteBuffers)
+			GET_GL_CALL(glBufferData)
+			GET_GL_CALL(glBufferSubData)
+			GET_GL_CALL(glBindBufferBase)
+			GET_GL_CALL(glMapBufferRange)
+			GET_GL_CALL(glUnmapBuffer)
+			GET_GL_CALL(glFenceSync)
+			GET_GL_CALL(glClientWaitSync)
+			GET_GL_CALL(glDeleteSync)
 			GET_GL_CALL(glCopyTexSubImage2D)
+			GET_GL_CALL(glTexStorage2D)
+			GET_GL_CALL(glCompressedTexSubImage2D)
+			GET_GL_CALL(glGetStringi)
 
 			GET_GL_CALL(glGenFramebuffersEXT)
 			GET_GL_CALL(glBindFramebufferEXT)
@@ -124,17 +252,138 @@ namespace {
 	static std::string mint_lib_identity{ "mint Minimal Interoperation Lib" };
 } // namespace
 
+// depth state of the passes writing gl_FragDepth
+struct GlDepthState {
+	GLboolean test = GL_FALSE;
+	GLint func = GL_LESS;
+	GLboolean mask = GL_TRUE;
+};
+
+// shadow copy of the GL bindings we save and restore around our own GL calls.
+// filled by interop::syncGlState() and kept up to date by our own bind calls,
+// so saving the previous state does not need glGet round-trips
+struct GlStateCache {
+	bool valid = false;
+	GLint framebuffer[2] = { 0, 0 }; // draw, read
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	GLint active_texture = GL_TEXTURE0;
+	GlDepthState depth;
+
+	interop::GlStateStatistics current_frame;
+	interop::GlStateStatistics last_frame;
+};
+
+// GL state is per context, and contexts are current per thread
+static GlStateCache& glState() {
+	thread_local std::unordered_map<HGLRC, GlStateCache> caches;
+	return caches[wglGetCurrentContext()];
+}
+
+static void bindFramebuffer(GLenum target, GLint fbo) {
+	mglBindFramebufferEXT(target, fbo);
+
+	auto& state = glState();
+	if (target == GL_FRAMEBUFFER_EXT || target == GL_DRAW_FRAMEBUFFER_EXT)
+		state.framebuffer[0] = fbo;
+	if (target == GL_FRAMEBUFFER_EXT || target == GL_READ_FRAMEBUFFER_EXT)
+		state.framebuffer[1] = fbo;
+}
+
+static void setViewport(GLint x, GLint y, GLint width, GLint height) {
+	glViewport(x, y, width, height);
+
+	auto& state = glState();
+	state.viewport[0] = x;
+	state.viewport[1] = y;
+	state.viewport[2] = width;
+	state.viewport[3] = height;
+}
+
+static void setActiveTexture(GLint texture_unit) {
+	mglActiveTexture(texture_unit);
+	glState().active_texture = texture_unit;
+}
+
+static GLint getActiveTexture() {
+	auto& state = glState();
+	if (state.valid) {
+		state.current_frame.queries_saved += 1;
+		return state.active_texture;
+	}
+
+	GLint active_texture = GL_TEXTURE0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+	state.current_frame.queries_issued += 1;
+	return active_texture;
+}
+
+// interop binds the textures it only uploads to or queries on a texture unit of its own,
+// so the bindings of the application on its units survive. returns the unit to restore
+static const GLint scratch_texture_unit = GL_TEXTURE0 + 15;
+
+static GLint bindScratchTexture(const GLuint texture) {
+	const GLint previous_active_texture = getActiveTexture();
+	setActiveTexture(scratch_texture_unit);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	return previous_active_texture;
+}
+
+static void unbindScratchTexture(const GLint previous_active_texture) {
+	glBindTexture(GL_TEXTURE_2D, 0);
+	setActiveTexture(previous_active_texture);
+}
+
+static GlDepthState getDepthState() {
+	auto& state = glState();
+	if (state.valid) {
+		state.current_frame.queries_saved += 3;
+		return state.depth;
+	}
+
+	GlDepthState depth;
+	depth.test = glIsEnabled(GL_DEPTH_TEST);
+	glGetIntegerv(GL_DEPTH_FUNC, &depth.func);
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depth.mask);
+	state.current_frame.queries_issued += 3;
+	return depth;
+}
+
+static void setDepthState(const GlDepthState& depth) {
+	if (depth.test)
+		glEnable(GL_DEPTH_TEST);
+	else
+		glDisable(GL_DEPTH_TEST);
+	glDepthFunc(depth.func);
+	glDepthMask(depth.mask);
+	glState().depth = depth;
+}
+
+// depth test that lets gl_FragDepth through unconditionally, or no depth test for color passes
+static const GlDepthState write_depth_state = { GL_TRUE, GL_ALWAYS, GL_TRUE };
+static const GlDepthState no_depth_state = { GL_FALSE, GL_ALWAYS, GL_TRUE };
+
 static const void savePreviousFbo(interop::glFramebuffer* fbo) {
+	auto& state = glState();
+	if (state.valid) {
+		fbo->m_previousFramebuffer[0] = state.framebuffer[0];
+		fbo->m_previousFramebuffer[1] = state.framebuffer[1];
+		for (int i = 0; i < 4; i++)
+			fbo->m_previousViewport[i] = state.viewport[i];
+		state.current_frame.queries_saved += 3;
+		return;
+	}
+
 	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING_EXT,
 		&fbo->m_previousFramebuffer[0]);
 	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING_EXT,
 		&fbo->m_previousFramebuffer[1]);
 	glGetIntegerv(GL_VIEWPORT, fbo->m_previousViewport);
+	state.current_frame.queries_issued += 3;
 };
 static const void restorePreviousFbo(interop::glFramebuffer* fbo) {
-	mglBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, fbo->m_previousFramebuffer[0]);
-	mglBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, fbo->m_previousFramebuffer[1]);
-	glViewport(fbo->m_previousViewport[0], fbo->m_previousViewport[1],
+	bindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, fbo->m_previousFramebuffer[0]);
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, fbo->m_previousFramebuffer[1]);
+	setViewport(fbo->m_previousViewport[0], fbo->m_previousViewport[1],
 		fbo->m_previousViewport[2], fbo->m_previousViewport[3]);
 
 	fbo->m_previousFramebuffer[0] = 0;
@@ -143,6 +392,31 @@ static const void restorePreviousFbo(interop::glFramebuffer* fbo) {
 		fbo->m_previousViewport[i] = 0;
 }
 
+void interop::syncGlState() {
+	auto& state = glState();
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING_EXT, &state.framebuffer[0]);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING_EXT, &state.framebuffer[1]);
+	glGetIntegerv(GL_VIEWPORT, state.viewport);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &state.active_texture);
+	state.depth.test = glIsEnabled(GL_DEPTH_TEST);
+	glGetIntegerv(GL_DEPTH_FUNC, &state.depth.func);
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &state.depth.mask);
+	state.valid = true;
+
+	state.current_frame.queries_issued += 7;
+	state.last_frame = state.current_frame;
+	state.current_frame = GlStateStatistics{};
+}
+
+void interop::invalidateGlState() {
+	glState().valid = false;
+}
+
+interop::GlStateStatistics interop::getGlStateStatistics() {
+	return glState().last_frame;
+}
+
 struct Addresses {
 	std::string send = "yet undefined";
 	std::string receive = "yet undefined";
@@ -169,6 +443,7 @@ static const std::string texture_sharing_address = "/mint/texturesharing/";
 
 static Addresses session_addresses;
 static interop::ImageProtocol session_texture_sharing;
+static interop::Role session_role;
 
 std::string to_string(interop::ImageType side) {
 	std::string ret;
@@ -183,6 +458,9 @@ std::string to_string(interop::ImageType side) {
 	case interop::ImageType::SingleStereo:
 		ret = "SingleStereo";
 		break;
+	case interop::ImageType::MultiView:
+		ret = "MultiView";
+		break;
 	default:
 		break;
 	}
@@ -195,6 +473,38 @@ void interop::init(Role r, DataProtocol dp, ImageProtocol ip) {
 
 	session_addresses = protocol_addresses[static_cast<unsigned int>(dp)].steering_rendering[static_cast<unsigned int>(r)];
 	session_texture_sharing = ip;
+	session_role = r;
+}
+
+// framebuffer textures get storage at a capacity somewhat larger than requested.
+// resizing within the capacity only changes the logical size (m_width, m_height), which
+// bind(), blitTexture() and the texture senders use as viewport and copy region.
+// storage is reallocated only if the requested size exceeds the capacity, or if it
+// falls below a quarter of the capacity area so we can reclaim the memory. small
+// capacities are never reclaimed, they would be reallocated on every resize.
+static const float framebuffer_capacity_growth = 1.25f;
+static const int framebuffer_capacity_alignment = 64;
+static const int framebuffer_capacity_reclaim_factor = 4;
+static const int framebuffer_capacity_reclaim_minimum = 512 * 512;
+
+// how long the network sender waits for the readback of the previous frame
+static const unsigned long long readback_wait_timeout_ns = 100000000ull;
+
+// how long packing waits for the sharing of an earlier frame from the same packed image
+static const unsigned long long target_wait_timeout_ns = 100000000ull;
+
+static int framebufferCapacity(const int size) {
+	const int grown = static_cast<int>(size * framebuffer_capacity_growth);
+	const int a = framebuffer_capacity_alignment;
+	return ((grown + a - 1) / a) * a;
+}
+
+static void allocateTextureStorage(GLenum internal_format, GLenum format, GLenum type,
+	const int width, const int height) {
+	if (mglTexStorage2D)
+		mglTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width, height);
+	else // pre GL 4.2 fallback
+		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, nullptr);
 }
 
 // GL functions are presented by Spout!
@@ -203,30 +513,35 @@ void interop::glFramebuffer::init(uint width, uint height) {
 
 	m_width = width;
 	m_height = height;
+	m_capacityWidth = framebufferCapacity(m_width);
+	m_capacityHeight = framebufferCapacity(m_height);
 
 	if (!m_glFbo)
 		mglGenFramebuffersEXT(1, &m_glFbo);
 
-	if (!m_glTextureRGBA8)
-		glGenTextures(1, &m_glTextureRGBA8);
+	// immutable storage can not be respecified, reallocating takes new texture names.
+	// users read the names from the framebuffer when they use them
+	if (m_glTextureRGBA8)
+		glDeleteTextures(1, &m_glTextureRGBA8);
+	if (m_glTextureDepth)
+		glDeleteTextures(1, &m_glTextureDepth);
+
+	glGenTextures(1, &m_glTextureRGBA8);
 	glBindTexture(GL_TEXTURE_2D, m_glTextureRGBA8);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA,
-		GL_UNSIGNED_BYTE, nullptr);
+	allocateTextureStorage(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, m_capacityWidth, m_capacityHeight);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	if (!m_glTextureDepth)
-		glGenTextures(1, &m_glTextureDepth);
+	glGenTextures(1, &m_glTextureDepth);
 	glBindTexture(GL_TEXTURE_2D, m_glTextureDepth);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, m_width, m_height, 0,
-		GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	allocateTextureStorage(GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT, GL_FLOAT, m_capacityWidth, m_capacityHeight);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	savePreviousFbo(this);
-	mglBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_glFbo);
+	bindFramebuffer(GL_FRAMEBUFFER_EXT, m_glFbo);
 	mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
 		GL_TEXTURE_2D, m_glTextureRGBA8, 0);
 	mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
@@ -254,23 +569,39 @@ void interop::glFramebuffer::destroy() {
 	m_glTextureDepth = 0;
 	m_width = 0;
 	m_height = 0;
+	m_capacityWidth = 0;
+	m_capacityHeight = 0;
 }
 
 void interop::glFramebuffer::resizeTexture(uint width, uint height) {
 	if (width == 0 || height == 0)
 		return;
 
-	if (m_width == width && m_height == height)
+	const int w = static_cast<int>(width);
+	const int h = static_cast<int>(height);
+
+	if (m_width == w && m_height == h)
+		return;
+
+	const bool exceeds_capacity = w > m_capacityWidth || h > m_capacityHeight;
+	const bool can_reclaim = m_capacityWidth * m_capacityHeight > framebuffer_capacity_reclaim_minimum
+		&& w * h * framebuffer_capacity_reclaim_factor < m_capacityWidth * m_capacityHeight
+		&& (framebufferCapacity(w) < m_capacityWidth || framebufferCapacity(h) < m_capacityHeight);
+
+	if (!m_glFbo || exceeds_capacity || can_reclaim) {
+		this->init(width, height);
 		return;
+	}
 
-	this->init(width, height);
+	m_width = w;
+	m_height = h;
 }
 
 void interop::glFramebuffer::bind() {
 	savePreviousFbo(this);
-	mglBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_glFbo);
+	bindFramebuffer(GL_FRAMEBUFFER_EXT, m_glFbo);
 	glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT);
-	glViewport(0, 0, m_width, m_height);
+	setViewport(0, 0, m_width, m_height);
 }
 
 void interop::glFramebuffer::unbind() { restorePreviousFbo(this); }
@@ -278,8 +609,8 @@ void interop::glFramebuffer::unbind() { restorePreviousFbo(this); }
 void interop::glFramebuffer::blitTexture() {
 	savePreviousFbo(this);
 
-	mglBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, m_previousFramebuffer[0]);
-	mglBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, m_glFbo);
+	bindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, m_previousFramebuffer[0]);
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, m_glFbo);
 
 	mglBlitFramebufferEXT(0, 0, m_width, m_height, m_previousViewport[0],
 		m_previousViewport[1], m_previousViewport[2],
@@ -289,6 +620,898 @@ void interop::glFramebuffer::blitTexture() {
 	restorePreviousFbo(this);
 }
 
+static uint compileShader(const GLenum type, std::vector<const char*> sources) {
+	const uint shader = mglCreateShader(type);
+	mglShaderSource(shader, static_cast<GLsizei>(sources.size()), sources.data(), NULL);
+	mglCompileShader(shader);
+	return shader;
+}
+
+// links and deletes the shaders. 0 if linking failed
+static uint linkProgram(const uint shader_a, const uint shader_b) {
+	const uint program = mglCreateProgram();
+	mglAttachShader(program, shader_a);
+	if (shader_b)
+		mglAttachShader(program, shader_b);
+	mglLinkProgram(program);
+
+	int success = 0;
+	mglGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		std::string infoLog;
+		infoLog.resize(512);
+		mglGetProgramInfoLog(program, 512, NULL,
+			const_cast<char*>(infoLog.c_str()));
+		std::cout << infoLog << std::endl;
+	}
+
+	mglDeleteShader(shader_a);
+	if (shader_b)
+		mglDeleteShader(shader_b);
+
+	return success ? program : 0;
+}
+
+static unsigned long long nowNs() {
+	return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+}
+
+// -------------------------------------------------
+// --- network image transport, ImageProtocol::Network
+// -------------------------------------------------
+
+// texture senders compare each image with the previous one per tile on the GPU and read back
+// only the tiles that changed. the publisher patches them into a persistent copy of the image
+// of each sender, and its worker thread run-length encodes the tiles dirty since the last send
+// (or stores them raw if that is not smaller). one message [topic][frame] per send goes out on
+// a PUB socket shared by all senders of the process, frames handed over while the worker is busy
+// are merged into the pending one. a message the queue of a receiver has no room for is not sent
+// at all, its tiles stay pending and go out with the next one. every keyframe_interval the message
+// holds all tiles, so receivers that joined late or lost a message recover.
+// receivers patch the tiles into their own persistent image in a worker thread and receive()
+// uploads the tiles changed since the last call into the texture.
+
+static const uint network_frame_magic = 0x464E494D; // "MINF"
+static const uint network_tile_size = 64;
+static const uint network_keyframe = 1u; // NetworkFrameHeader::flags
+static const int network_high_water_mark = 2; // frames zmq queues per connection before refusing more
+static const unsigned long long network_send_retry_ns = 1000000ull; // wait after a full queue refused a message
+static const std::string network_image_address[] = { "tcp://localhost:12347" /*steering*/, "tcp://*:12347" /*rendering*/ };
+
+enum class NetworkTileEncoding : uint {
+	Raw = 0,
+	RunLength = 1, // (run length, pixel) pairs
+};
+
+// start of a frame message, followed by tile_count tiles of [tile index][encoding][word count][words]
+struct NetworkFrameHeader {
+	uint magic = network_frame_magic;
+	uint sequence = 0; // frames handed to the sender, merged frames are skipped
+	uint message = 0; // messages of the topic, a gap means the receiver lost tiles
+	uint flags = 0;
+	uint width = 0;
+	uint height = 0;
+	uint tile_size = network_tile_size;
+	uint tile_count = 0;
+	unsigned long long send_ns = 0;
+};
+static const uint network_header_words = sizeof(NetworkFrameHeader) / sizeof(uint);
+
+struct NetworkFrame {
+	uint sequence = 0;
+	uint width = 0;
+	uint height = 0;
+	unsigned long long send_ns = 0; // sender clock when the frame was handed to the transport
+	std::vector<uint> pixels; // rows bottom-up, as read by glReadPixels
+	std::vector<uint> dirty; // bitmask of the tiles changed since the image was last taken
+};
+
+static interop::NetworkImageSettings network_image_settings;
+
+void interop::setNetworkImageSettings(const NetworkImageSettings& settings) {
+	network_image_settings = settings;
+}
+
+static std::string networkImageAddress() {
+	if (!network_image_settings.address.empty())
+		return network_image_settings.address;
+
+	return network_image_address[static_cast<uint>(session_role)];
+}
+
+static interop::Rect networkTile(const uint tile, const uint tile_size, const uint width, const uint height) {
+	const uint tiles_x = (width + tile_size - 1) / tile_size;
+	const uint x = (tile % tiles_x) * tile_size;
+	const uint y = (tile / tiles_x) * tile_size;
+	return { x, y, (x + tile_size < width ? tile_size : width - x), (y + tile_size < height ? tile_size : height - y) };
+}
+
+static uint networkTileCount(const uint tile_size, const uint width, const uint height) {
+	return ((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+}
+
+// resizes the image, marking all tiles dirty if the size changed
+static void resizeNetworkFrame(NetworkFrame& frame, const uint width, const uint height) {
+	const uint mask_words = (networkTileCount(network_tile_size, width, height) + 31) / 32;
+	if (frame.width == width && frame.height == height && frame.dirty.size() == mask_words)
+		return;
+
+	frame.width = width;
+	frame.height = height;
+	frame.pixels.resize(static_cast<size_t>(width) * height);
+	frame.dirty.assign(mask_words, ~0u);
+}
+
+static bool isTileDirty(const NetworkFrame& frame, const uint tile) {
+	return (frame.dirty[tile / 32] >> (tile % 32)) & 1u;
+}
+
+// copies a tile from source to target, both of the same size, and marks it dirty in target
+static void copyNetworkTile(const NetworkFrame& source, const uint tile, NetworkFrame& target) {
+	const auto rect = networkTile(tile, network_tile_size, source.width, source.height);
+	for (uint y = rect.y; y < rect.y + rect.height; y++) {
+		const size_t row = static_cast<size_t>(y) * source.width + rect.x;
+		std::memcpy(target.pixels.data() + row, source.pixels.data() + row, rect.width * sizeof(uint));
+	}
+	target.dirty[tile / 32] |= 1u << (tile % 32);
+}
+
+static void compressTile(const NetworkFrame& frame, const uint tile, std::vector<uint>& out) {
+	const auto rect = networkTile(tile, network_tile_size, frame.width, frame.height);
+	const size_t raw_words = static_cast<size_t>(rect.width) * rect.height;
+
+	out.push_back(tile);
+	const size_t encoding_at = out.size();
+	out.push_back(static_cast<uint>(NetworkTileEncoding::RunLength));
+	out.push_back(0);
+	const size_t words_at = out.size();
+
+	uint run = 0, value = 0;
+	for (uint y = rect.y; y < rect.y + rect.height && out.size() - words_at < raw_words; y++) {
+		const uint* row = frame.pixels.data() + static_cast<size_t>(y) * frame.width;
+		for (uint x = rect.x; x < rect.x + rect.width; x++) {
+			if (run && row[x] == value) {
+				run++;
+				continue;
+			}
+			if (run) {
+				out.push_back(run);
+				out.push_back(value);
+			}
+			run = 1;
+			value = row[x];
+		}
+	}
+	if (run) {
+		out.push_back(run);
+		out.push_back(value);
+	}
+
+	if (out.size() - words_at >= raw_words) {
+		out.resize(words_at);
+		out[encoding_at] = static_cast<uint>(NetworkTileEncoding::Raw);
+		for (uint y = rect.y; y < rect.y + rect.height; y++) {
+			const uint* row = frame.pixels.data() + static_cast<size_t>(y) * frame.width;
+			out.insert(out.end(), row + rect.x, row + rect.x + rect.width);
+		}
+	}
+	out[encoding_at + 1] = static_cast<uint>(out.size() - words_at);
+}
+
+// reads one tile at in and writes its pixels into frame, false on malformed data
+static bool decompressTile(const uint*& in, const uint* end, const uint tile_size, NetworkFrame& frame, uint& tile) {
+	if (end - in < 3)
+		return false;
+
+	tile = in[0];
+	const auto encoding = static_cast<NetworkTileEncoding>(in[1]);
+	const uint words = in[2];
+	in += 3;
+	if (static_cast<size_t>(end - in) < words || tile >= networkTileCount(tile_size, frame.width, frame.height))
+		return false;
+
+	const uint* data = in;
+	in += words;
+
+	const auto rect = networkTile(tile, tile_size, frame.width, frame.height);
+	uint* pixels = frame.pixels.data();
+
+	if (encoding == NetworkTileEncoding::Raw) {
+		if (words != rect.width * rect.height)
+			return false;
+		for (uint y = 0; y < rect.height; y++)
+			std::memcpy(pixels + static_cast<size_t>(rect.y + y) * frame.width + rect.x, data + y * rect.width, rect.width * sizeof(uint));
+		return true;
+	}
+
+	if (encoding != NetworkTileEncoding::RunLength || words % 2)
+		return false;
+
+	uint x = 0, y = 0;
+	for (uint i = 0; i < words; i += 2) {
+		for (uint run = data[i]; run > 0; run--) {
+			if (y == rect.height)
+				return false;
+			pixels[static_cast<size_t>(rect.y + y) * frame.width + rect.x + x] = data[i + 1];
+			if (++x == rect.width) {
+				x = 0;
+				y++;
+			}
+		}
+	}
+	return y == rect.height;
+}
+
+// encodes the dirty tiles of frame
+static void compressFrame(const NetworkFrame& frame, const uint message, const uint flags, std::vector<uint>& out) {
+	NetworkFrameHeader header;
+	header.sequence = frame.sequence;
+	header.message = message;
+	header.flags = flags;
+	header.width = frame.width;
+	header.height = frame.height;
+	header.send_ns = frame.send_ns;
+
+	out.resize(network_header_words);
+	const uint tiles = networkTileCount(network_tile_size, frame.width, frame.height);
+	for (uint tile = 0; tile < tiles; tile++) {
+		if (isTileDirty(frame, tile)) {
+			compressTile(frame, tile, out);
+			header.tile_count++;
+		}
+	}
+	std::memcpy(out.data(), &header, sizeof(header));
+}
+
+// decodes the tiles of a message into frame and marks them dirty. frame keeps the tiles of earlier messages
+static bool decompressFrame(const std::vector<uint>& message, const NetworkFrameHeader& header, NetworkFrame& frame) {
+	frame.sequence = header.sequence;
+	frame.send_ns = header.send_ns;
+	resizeNetworkFrame(frame, header.width, header.height);
+
+	const uint* in = message.data() + network_header_words;
+	const uint* end = message.data() + message.size();
+	for (uint i = 0; i < header.tile_count; i++) {
+		uint tile = 0;
+		if (!decompressTile(in, end, header.tile_size, frame, tile))
+			return false;
+		frame.dirty[tile / 32] |= 1u << (tile % 32);
+	}
+
+	return in == end;
+}
+
+// compares the image handed to a network sender with the previous one per tile. the compute pass
+// writes the dirty tile bitmask and copies the dirty tiles into a buffer the CPU maps a frame later,
+// so only changed tiles are read back. needs GL 4.3, senders read back whole images without it
+struct DirtyTileDetector {
+	uint shader = 0;
+	int uniform_locations[4] = { 0 };
+	uint previous = 0; // r32ui copy of the last compared image
+	uint previous_width = 0, previous_height = 0;
+	uint buffers[2] = { 0, 0 }; // dirty count, bitmask, tile of each slot, pixels of each slot
+	uint buffer_bytes[2] = { 0, 0 };
+	bool supported = true;
+	bool initialized = false;
+
+	static uint maskWords(const uint tiles) { return (tiles + 31) / 32; }
+	static size_t tilesOffset(const uint tiles) { return 1 + maskWords(tiles); }
+	static size_t pixelsOffset(const uint tiles) { return tilesOffset(tiles) + tiles; }
+
+	bool init() {
+		initialized = true;
+
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		supported = (major > 4 || (major == 4 && minor >= 3)) && mglDispatchCompute && mglBindImageTexture
+			&& mglMemoryBarrier && mglBindBufferBase && mglBufferSubData;
+		if (supported) {
+			const std::string header = "#version 430\n#define TILE_SIZE " + std::to_string(network_tile_size) + "\n";
+			const uint compute_shader = compileShader(GL_COMPUTE_SHADER, { header.c_str(), dirty_tiles_shader });
+			shader = linkProgram(compute_shader, 0);
+			supported = shader != 0;
+		}
+		if (!supported) {
+			std::cout << "mint: dirty tile detection needs GL 4.3, sending whole network images" << std::endl;
+			return false;
+		}
+
+		uniform_locations[0] = mglGetUniformLocation(shader, "image");
+		uniform_locations[1] = mglGetUniformLocation(shader, "image_size");
+		uniform_locations[2] = mglGetUniformLocation(shader, "all_dirty");
+		uniform_locations[3] = mglGetUniformLocation(shader, "tiles_x");
+		mglGenBuffers(2, buffers);
+		return true;
+	}
+
+	void destroy() {
+		if (shader)
+			mglDeleteProgram(shader);
+		if (previous)
+			glDeleteTextures(1, &previous);
+		if (buffers[0])
+			mglDeleteBuffers(2, buffers);
+		*this = DirtyTileDetector{};
+	}
+
+	// compares texture with the previous image into the buffer of slot and keeps texture for the next compare
+	void compare(const uint slot, const uint texture, const uint width, const uint height) {
+		const uint tiles_x = (width + network_tile_size - 1) / network_tile_size;
+		const uint tiles = networkTileCount(network_tile_size, width, height);
+
+		const bool all_dirty = previous_width != width || previous_height != height;
+		if (all_dirty) {
+			if (previous)
+				glDeleteTextures(1, &previous);
+			glGenTextures(1, &previous);
+			const GLint previous_active_texture = bindScratchTexture(previous);
+			mglTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+			unbindScratchTexture(previous_active_texture);
+			previous_width = width;
+			previous_height = height;
+		}
+
+		mglBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+		const uint bytes = static_cast<uint>((pixelsOffset(tiles) + static_cast<size_t>(tiles) * network_tile_size * network_tile_size) * sizeof(uint));
+		if (buffer_bytes[slot] < bytes) {
+			// written by the GPU and read by the CPU, so drivers keep it in host memory
+			mglBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_STREAM_READ);
+			buffer_bytes[slot] = bytes;
+		}
+		const std::vector<uint> zeros(tilesOffset(tiles), 0);
+		mglBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, zeros.size() * sizeof(uint), zeros.data());
+		mglBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		mglUseProgram(shader);
+		const GLint previous_active_texture = bindScratchTexture(texture);
+		mglUniform1i(uniform_locations[0], scratch_texture_unit - GL_TEXTURE0);
+		mglUniform2i(uniform_locations[1], static_cast<int>(width), static_cast<int>(height));
+		mglUniform1i(uniform_locations[2], all_dirty);
+		mglUniform1i(uniform_locations[3], static_cast<int>(tiles_x));
+		mglBindImageTexture(0, previous, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+		mglBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffers[slot]);
+
+		mglDispatchCompute(tiles_x, tiles / tiles_x, 1);
+		mglMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		mglBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		mglBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+		unbindScratchTexture(previous_active_texture);
+		mglUseProgram(0);
+	}
+
+	// patches the dirty tiles of a finished compare into frame, which has the compared size
+	void read(const uint slot, NetworkFrame& frame) {
+		const uint tiles = networkTileCount(network_tile_size, frame.width, frame.height);
+		const size_t tile_words = network_tile_size * network_tile_size;
+
+		mglBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+		uint dirty_count = 0;
+		if (const uint* words = static_cast<const uint*>(mglMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint), GL_MAP_READ_BIT))) {
+			dirty_count = words[0];
+			mglUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		}
+
+		// map the bitmask, the slot table and only as many tile slots as were written
+		const size_t words_used = pixelsOffset(tiles) + dirty_count * tile_words;
+		const uint* words = dirty_count == 0 ? nullptr : static_cast<const uint*>(
+			mglMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, words_used * sizeof(uint), GL_MAP_READ_BIT));
+		if (words) {
+			for (uint i = 0; i < dirty_count && i < tiles; i++) {
+				const uint tile = words[tilesOffset(tiles) + i];
+				const uint* tile_pixels = words + pixelsOffset(tiles) + i * tile_words;
+				const auto rect = networkTile(tile, network_tile_size, frame.width, frame.height);
+				for (uint y = 0; y < rect.height; y++)
+					std::memcpy(frame.pixels.data() + static_cast<size_t>(rect.y + y) * frame.width + rect.x,
+						tile_pixels + y * network_tile_size, rect.width * sizeof(uint));
+			}
+			for (uint w = 0; w < maskWords(tiles); w++)
+				frame.dirty[w] |= words[1 + w];
+			mglUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		}
+		mglBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	// one work group per tile, every invocation covers a block of TILE_SIZE / 8 pixels squared
+	static constexpr const char* dirty_tiles_shader = R"(
+	layout(local_size_x = 8, local_size_y = 8) in;
+
+	uniform sampler2D image;
+	uniform ivec2 image_size;
+	uniform bool all_dirty;
+	uniform int tiles_x;
+	layout(r32ui, binding = 0) uniform uimage2D previous;
+
+	layout(std430, binding = 0) buffer DirtyTiles {
+		uint dirty_count;
+		uint words[]; // bitmask, then the tile index of each slot, then TILE_SIZE squared pixels per slot
+	};
+
+	const int block = TILE_SIZE / 8;
+	shared bool tile_dirty;
+	shared uint tile_slot;
+
+	void main() {
+		const ivec2 tile = ivec2(gl_WorkGroupID.xy);
+		const ivec2 local = ivec2(gl_LocalInvocationID.xy) * block;
+		const ivec2 origin = tile * TILE_SIZE + local;
+		const int tiles = tiles_x * int(gl_NumWorkGroups.y);
+		const int mask_words = (tiles + 31) / 32;
+
+		if (gl_LocalInvocationIndex == 0)
+			tile_dirty = all_dirty;
+		memoryBarrierShared();
+		barrier();
+
+		bool changed = false;
+		for (int y = 0; y < block; y++)
+			for (int x = 0; x < block; x++) {
+				const ivec2 pixel = origin + ivec2(x, y);
+				if (pixel.x < image_size.x && pixel.y < image_size.y)
+					changed = changed || packUnorm4x8(texelFetch(image, pixel, 0)) != imageLoad(previous, pixel).r;
+			}
+		if (changed)
+			tile_dirty = true;
+		memoryBarrierShared();
+		barrier();
+
+		if (gl_LocalInvocationIndex == 0 && tile_dirty) {
+			const uint index = uint(tile.y * tiles_x + tile.x);
+			tile_slot = atomicAdd(dirty_count, 1u);
+			atomicOr(words[index / 32u], 1u << (index % 32u));
+			words[mask_words + tile_slot] = index;
+		}
+		memoryBarrierShared();
+		barrier();
+
+		if (!tile_dirty)
+			return;
+
+		const uint base = uint(mask_words + tiles) + tile_slot * uint(TILE_SIZE * TILE_SIZE);
+		for (int y = 0; y < block; y++)
+			for (int x = 0; x < block; x++) {
+				const ivec2 pixel = origin + ivec2(x, y);
+				if (pixel.x >= image_size.x || pixel.y >= image_size.y)
+					continue;
+				const uint color = packUnorm4x8(texelFetch(image, pixel, 0));
+				words[base + uint((local.y + y) * TILE_SIZE + local.x + x)] = color;
+				imageStore(previous, pixel, uvec4(color));
+			}
+	}
+	)";
+};
+
+// the PUB socket of all texture senders, running while at least one sender uses it
+struct NetworkImagePublisher {
+	struct Pending {
+		NetworkFrame frame; // latest image of the topic, dirty holds the tiles not sent yet
+		bool fresh = false; // frames were submitted since the worker took the last one
+		unsigned long long sent_ns = 0;
+		unsigned long long retry_ns = 0; // not sent again before, set when a full queue refused the message
+		unsigned long long refused_ns = 0; // since when full queues refuse the messages, 0 while they go out
+		unsigned long long keyframe_ns = 0;
+		uint message = 0;
+	};
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::unordered_map<std::string, Pending> pending; // per topic
+	std::thread worker;
+	bool running = false;
+	uint users = 0;
+
+	~NetworkImagePublisher() {
+		if (worker.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				running = false;
+			}
+			wake.notify_all();
+			worker.join();
+		}
+	}
+
+	void acquire() {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (users++ > 0)
+			return;
+
+		const auto address = networkImageAddress();
+		running = true;
+		worker = std::thread{ [this, address]() { run(address); } };
+		std::cout << "mint: sending network images on " << address << std::endl;
+	}
+
+	void release(const std::string& topic) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending.erase(topic);
+			if (users == 0 || --users > 0)
+				return;
+			running = false;
+		}
+		wake.notify_all();
+		worker.join();
+	}
+
+	// patches the dirty tiles of frame into the image of topic
+	void submit(const std::string& topic, const NetworkFrame& frame) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& next = pending[topic];
+			resizeNetworkFrame(next.frame, frame.width, frame.height);
+			next.frame.sequence = frame.sequence;
+			next.frame.send_ns = frame.send_ns;
+
+			const uint tiles = networkTileCount(network_tile_size, frame.width, frame.height);
+			for (uint tile = 0; tile < tiles; tile++)
+				if (isTileDirty(frame, tile))
+					copyNetworkTile(frame, tile, next.frame);
+			next.fresh = true;
+		}
+		wake.notify_one();
+	}
+
+	void run(const std::string address) {
+		zmq::socket_t socket(g_zmqContext, zmq::socket_type::pub);
+		try {
+			socket.setsockopt(ZMQ_IDENTITY, mint_lib_identity.data(), mint_lib_identity.size());
+			socket.setsockopt(ZMQ_SNDHWM, network_high_water_mark);
+			// a full queue refuses messages instead of dropping them, so receivers never miss tiles
+			socket.setsockopt(ZMQ_XPUB_NODROP, 1);
+			socket.setsockopt(ZMQ_LINGER, 0);
+			socket.bind(address);
+		}
+		catch (std::exception& e) {
+			std::cout << "mint: binding network image socket failed: " << e.what() << " - " << address << std::endl;
+			return;
+		}
+
+		// frames at most every interval_ns per topic, the rest is paced by how fast we get them out
+		const unsigned long long interval_ns = network_image_settings.max_fps > 0.0f
+			? static_cast<unsigned long long>(1e9 / network_image_settings.max_fps) : 0ull;
+		const unsigned long long keyframe_interval_ns = static_cast<unsigned long long>(1e9 * network_image_settings.keyframe_interval_s);
+
+		NetworkFrame frame; // the tiles to send, copied out of the pending image
+		std::string topic;
+		std::vector<uint> message;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		while (running) {
+			const unsigned long long now = nowNs();
+			unsigned long long wait_ns = 0;
+			Pending* next = nullptr;
+			for (auto& p : pending) {
+				if (!p.second.fresh)
+					continue;
+				const unsigned long long paced = p.second.sent_ns + interval_ns;
+				const unsigned long long due = (p.second.retry_ns > paced) ? p.second.retry_ns : paced;
+				if (now >= due) {
+					topic = p.first;
+					next = &p.second;
+					break;
+				}
+				if (wait_ns == 0 || due - now < wait_ns)
+					wait_ns = due - now;
+			}
+
+			if (!next) {
+				if (wait_ns)
+					wake.wait_for(lock, std::chrono::nanoseconds(wait_ns));
+				else
+					wake.wait(lock);
+				continue;
+			}
+
+			auto& image = next->frame;
+			// a receiver that did not drain its queue for a keyframe interval would hold back all others.
+			// it misses a keyframe instead and recovers with the next one
+			const bool stalled = next->refused_ns != 0 && now - next->refused_ns >= keyframe_interval_ns;
+			const bool keyframe = stalled || next->message == 0 || now - next->keyframe_ns >= keyframe_interval_ns;
+			if (keyframe) {
+				next->keyframe_ns = now;
+				image.dirty.assign(image.dirty.size(), ~0u);
+			}
+
+			resizeNetworkFrame(frame, image.width, image.height);
+			frame.sequence = image.sequence;
+			frame.send_ns = image.send_ns;
+			frame.dirty.assign(frame.dirty.size(), 0u);
+			const uint tiles = networkTileCount(network_tile_size, image.width, image.height);
+			for (uint tile = 0; tile < tiles; tile++)
+				if (isTileDirty(image, tile))
+					copyNetworkTile(image, tile, frame);
+			image.dirty.assign(image.dirty.size(), 0u);
+
+			const uint message_index = next->message++;
+			next->fresh = false;
+			next->sent_ns = now;
+			lock.unlock();
+
+			compressFrame(frame, message_index, keyframe ? network_keyframe : 0u, message);
+			zmq::message_t topic_msg{ topic.data(), topic.size() };
+			zmq::message_t frame_msg{ message.data(), message.size() * sizeof(uint) };
+			bool refused = false;
+			try {
+				// the queues are only checked at the first part, the rest of a message always fits
+				if (stalled)
+					socket.setsockopt(ZMQ_XPUB_NODROP, 0);
+				refused = !socket.send(topic_msg, ZMQ_SNDMORE | ZMQ_DONTWAIT);
+				if (!refused)
+					socket.send(frame_msg);
+				if (stalled)
+					socket.setsockopt(ZMQ_XPUB_NODROP, 1);
+			}
+			catch (std::exception& e) {
+				std::cout << "mint: sending network image failed: " << e.what() << std::endl;
+			}
+
+			lock.lock();
+			const auto sent = pending.find(topic); // the sender may have been released meanwhile
+			if (sent != pending.end() && !refused)
+				sent->second.refused_ns = 0;
+			else if (sent != pending.end()) {
+				// the tiles go out with the next message, which takes the index of this one
+				Pending& again = sent->second;
+				if (again.frame.dirty.size() == frame.dirty.size())
+					for (size_t w = 0; w < frame.dirty.size(); w++)
+						again.frame.dirty[w] |= frame.dirty[w];
+				if (keyframe)
+					again.keyframe_ns = 0;
+				again.message = message_index;
+				again.fresh = true;
+				again.retry_ns = now + network_send_retry_ns;
+				again.refused_ns = (again.refused_ns != 0) ? again.refused_ns : now;
+			}
+		}
+		lock.unlock();
+
+		socket.close();
+	}
+};
+static NetworkImagePublisher network_publisher;
+
+// per texture sender: the frame handed over last time is read back and given to the publisher,
+// as dirty tiles if the GPU supports the detection, as whole image through pixel pack buffers otherwise
+struct NetworkImageSender {
+	std::string topic;
+	DirtyTileDetector detector;
+	uint read_fbo = 0;
+	uint pbos[2] = { 0, 0 };
+	uint pbo_bytes[2] = { 0, 0 };
+	void* fences[2] = { nullptr, nullptr };
+	NetworkFrame frames[2]; // metadata of the frames in flight
+	NetworkFrame image; // tiles of the frame read back last, patched into the publisher image
+	uint slot = 0;
+	uint sequence = 0;
+};
+
+static void sendNetworkImage(NetworkImageSender& network, const uint texture, const uint width, const uint height) {
+	interop::glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+
+	if (!network.detector.initialized)
+		network.detector.init();
+	const bool tiles = network.detector.supported;
+
+	const uint slot = network.slot;
+	if (tiles) {
+		network.detector.compare(slot, texture, width, height);
+	}
+	else {
+		if (!network.read_fbo) {
+			mglGenFramebuffersEXT(1, &network.read_fbo);
+			mglGenBuffers(2, network.pbos);
+		}
+
+		const uint bytes = width * height * sizeof(uint);
+		bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, network.read_fbo);
+		mglFramebufferTexture2DEXT(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, texture, 0);
+		mglBindBuffer(GL_PIXEL_PACK_BUFFER, network.pbos[slot]);
+		if (network.pbo_bytes[slot] < bytes) {
+			mglBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+			network.pbo_bytes[slot] = bytes;
+		}
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		mglBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	if (network.fences[slot])
+		mglDeleteSync(network.fences[slot]);
+	network.fences[slot] = mglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	network.frames[slot].sequence = ++network.sequence;
+	network.frames[slot].width = width;
+	network.frames[slot].height = height;
+	network.frames[slot].send_ns = nowNs();
+
+	// the readback of the previous frame had a whole frame to finish
+	const uint previous = slot ^ 1;
+	if (void* fence = network.fences[previous]) {
+		const GLenum status = mglClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, readback_wait_timeout_ns);
+		mglDeleteSync(fence);
+		network.fences[previous] = nullptr;
+
+		const auto& frame = network.frames[previous];
+		auto& image = network.image;
+		const bool resized = image.width != frame.width || image.height != frame.height;
+		resizeNetworkFrame(image, frame.width, frame.height);
+		image.sequence = frame.sequence;
+		image.send_ns = frame.send_ns;
+		image.dirty.assign(image.dirty.size(), 0u);
+
+		const bool ready = status != GL_TIMEOUT_EXPIRED && status != GL_WAIT_FAILED;
+		if (!ready && tiles)
+			network.detector.previous_width = 0; // the next compare has to find the tiles we lost
+		if (ready && tiles) {
+			network.detector.read(previous, image);
+			network_publisher.submit(network.topic, image);
+		}
+		else if (ready) {
+			mglBindBuffer(GL_PIXEL_PACK_BUFFER, network.pbos[previous]);
+			if (const uint* pixels = static_cast<const uint*>(mglMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.width * frame.height * sizeof(uint), GL_MAP_READ_BIT))) {
+				// without the GPU pass we find the dirty tiles by comparing with the last image
+				const uint tile_count = networkTileCount(network_tile_size, frame.width, frame.height);
+				for (uint tile = 0; tile < tile_count; tile++) {
+					const auto rect = networkTile(tile, network_tile_size, frame.width, frame.height);
+					for (uint y = rect.y; y < rect.y + rect.height; y++) {
+						const size_t row = static_cast<size_t>(y) * frame.width + rect.x;
+						if (std::memcmp(image.pixels.data() + row, pixels + row, rect.width * sizeof(uint)) != 0) {
+							std::memcpy(image.pixels.data() + row, pixels + row, rect.width * sizeof(uint));
+							image.dirty[tile / 32] |= 1u << (tile % 32);
+						}
+					}
+				}
+				if (resized)
+					image.dirty.assign(image.dirty.size(), ~0u);
+				mglUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				network_publisher.submit(network.topic, image);
+			}
+			mglBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+	}
+	network.slot = previous;
+
+	restorePreviousFbo(&fbo_backup);
+}
+
+static void destroyNetworkImageSender(NetworkImageSender& network) {
+	for (auto& fence : network.fences) {
+		if (fence)
+			mglDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (network.read_fbo) {
+		mglDeleteFramebuffersEXT(1, &network.read_fbo);
+		mglDeleteBuffers(2, network.pbos);
+	}
+	network.read_fbo = 0;
+	network.pbo_bytes[0] = network.pbo_bytes[1] = 0;
+	network.detector.destroy();
+	network_publisher.release(network.topic);
+}
+
+// per texture receiver: SUB socket worker patching the tiles of its topic into the latest image
+struct NetworkImageReceiver {
+	std::string topic;
+	std::thread worker;
+	std::atomic<bool> running{ false };
+
+	std::mutex mutex;
+	NetworkFrame latest; // dirty holds the tiles receive() did not upload yet
+	bool fresh = false; // latest changed since receive() took it
+
+	~NetworkImageReceiver() { stop(); }
+
+	void start(const std::string address) {
+		running = true;
+		worker = std::thread{ [this, address]() { run(address); } };
+	}
+
+	void stop() {
+		running = false;
+		if (worker.joinable())
+			worker.join();
+	}
+
+	void run(const std::string address) {
+		zmq::socket_t socket(g_zmqContext, zmq::socket_type::sub);
+		try {
+			socket.setsockopt(ZMQ_IDENTITY, mint_lib_identity.data(), mint_lib_identity.size());
+			socket.setsockopt(ZMQ_SUBSCRIBE, topic.data(), topic.size());
+			socket.setsockopt(ZMQ_RCVTIMEO, 5/*ms*/);
+			socket.setsockopt(ZMQ_RCVHWM, network_high_water_mark);
+			socket.setsockopt(ZMQ_LINGER, 0);
+			socket.connect(address);
+		}
+		catch (std::exception& e) {
+			std::cout << "mint: connecting network image socket failed: " << e.what() << " - " << address << std::endl;
+			return;
+		}
+
+		zmq::message_t topic_msg;
+		zmq::message_t frame_msg;
+		std::vector<zmq::message_t> queued; // frames of the topic received in one go, oldest first
+		std::vector<uint> message;
+		NetworkFrame image; // all tiles received so far
+		bool valid = false; // image is complete, false until the first keyframe and after lost messages
+		uint next_message = 0;
+
+		// true if a message was received, it is queued if it belongs to the topic
+		const auto receive_frame = [&](const zmq::recv_flags flags) {
+			if (!socket.recv(topic_msg, flags))
+				return false;
+			if (!topic_msg.more() || !socket.recv(frame_msg, flags))
+				return true;
+			// subscriptions match by prefix, so we check the whole topic
+			if (topic_msg.to_string_view() == topic)
+				queued.push_back(std::move(frame_msg));
+			return true;
+		};
+
+		const auto is_keyframe = [](const zmq::message_t& frame) {
+			NetworkFrameHeader header;
+			if (frame.size() < sizeof(header))
+				return false;
+			std::memcpy(static_cast<void*>(&header), frame.data(), sizeof(header));
+			return header.magic == network_frame_magic && (header.flags & network_keyframe) != 0;
+		};
+
+		while (running) {
+			queued.clear();
+			if (!receive_frame(zmq::recv_flags::none))
+				continue;
+			// drain what is queued already. the tiles patch the image in order, but the latest keyframe
+			// replaces everything before it, so the frames before it are not decoded
+			while (receive_frame(zmq::recv_flags::dontwait))
+				;
+			size_t first = 0;
+			for (size_t i = 0; i < queued.size(); i++)
+				if (is_keyframe(queued[i]))
+					first = i;
+
+			for (size_t i = first; i < queued.size(); i++) {
+				NetworkFrameHeader header;
+				message.resize((queued[i].size() + sizeof(uint) - 1) / sizeof(uint));
+				std::memcpy(message.data(), queued[i].data(), queued[i].size());
+				if (message.size() < network_header_words)
+					continue;
+				std::memcpy(static_cast<void*>(&header), message.data(), sizeof(header));
+				if (header.magic != network_frame_magic || header.tile_size != network_tile_size || header.width == 0 || header.height == 0)
+					continue;
+
+				// tiles only patch a complete image of the same size, otherwise wait for the next keyframe
+				const bool keyframe = header.flags & network_keyframe;
+				if (!keyframe && (!valid || header.message != next_message || header.width != image.width || header.height != image.height)) {
+					valid = false;
+					continue;
+				}
+				next_message = header.message + 1;
+
+				image.dirty.assign(image.dirty.size(), 0u);
+				valid = decompressFrame(message, header, image);
+				if (!valid) {
+					std::cout << "mint: dropping malformed network image on " << topic << std::endl;
+					continue;
+				}
+
+				std::lock_guard<std::mutex> lock(mutex);
+				resizeNetworkFrame(latest, image.width, image.height);
+				latest.sequence = image.sequence;
+				latest.send_ns = image.send_ns;
+				const uint tiles = networkTileCount(network_tile_size, image.width, image.height);
+				for (uint tile = 0; tile < tiles; tile++)
+					if (isTileDirty(image, tile))
+						copyNetworkTile(image, tile, latest);
+				fresh = true;
+			}
+		}
+
+		socket.close();
+	}
+};
+
 #define m_spout (static_cast<SpoutSender *>(m_sender.get()))
 #define error                                                                  \
   {                                                                            \
@@ -317,11 +1540,23 @@ void interop::TextureSender::init(std::string name, uint width, uint height) {
 
 	m_name = texture_sharing_address + name;
 
-	m_name.resize(256, '\0'); // Spout doc says sender name MUST have 256 bytes
-
 	m_width = width;
 	m_height = height;
 
+	if (session_texture_sharing == ImageProtocol::Network) {
+		auto network = std::make_shared<NetworkImageSender>();
+		network->topic = m_name;
+		network_publisher.acquire();
+		m_sender = network;
+		m_protocol = ImageProtocol::Network;
+		return;
+	}
+	if (m_protocol == ImageProtocol::Network)
+		m_sender = std::make_shared<SpoutSender>();
+	m_protocol = session_texture_sharing;
+
+	m_name.resize(256, '\0'); // Spout doc says sender name MUST have 256 bytes
+
 	m_spout->SetVerticalSync(0);
 	m_spout->SetDX9(false);
 
@@ -345,7 +1580,10 @@ void interop::TextureSender::destroy() {
 	if (!m_sender)
 		return;
 
-	m_spout->ReleaseSender();
+	if (m_protocol == ImageProtocol::Network)
+		destroyNetworkImageSender(*static_cast<NetworkImageSender*>(m_sender.get()));
+	else
+		m_spout->ReleaseSender();
 	m_width = 0;
 	m_height = 0;
 	m_name = "";
@@ -362,7 +1600,8 @@ bool interop::TextureSender::resize(uint width, uint height) {
 		m_width = width;
 		m_height = height;
 
-		m_spout->UpdateSender(m_name.c_str(), m_width, m_height);
+		if (m_protocol != ImageProtocol::Network)
+			m_spout->UpdateSender(m_name.c_str(), m_width, m_height);
 	}
 
 	return true;
@@ -376,12 +1615,44 @@ void interop::TextureSender::send(uint textureHandle, uint width,
 	if (!resize(width, height))
 		return;
 
-	m_spout->SendTexture(textureHandle, GL_TEXTURE_2D, m_width, m_height);
+	if (m_protocol == ImageProtocol::Network) {
+		sendNetworkImage(*static_cast<NetworkImageSender*>(m_sender.get()), textureHandle, m_width, m_height);
+		return;
+	}
+
+	// spout binds its own fbo for the copy and rebinds the host fbo afterwards,
+	// which has to be the one that is actually bound
+	auto& state = glState();
+	GLint host_fbo = 0;
+	if (state.valid) {
+		host_fbo = state.framebuffer[0];
+		state.current_frame.queries_saved += 1;
+	}
+	else {
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING_EXT, &host_fbo);
+		state.current_frame.queries_issued += 1;
+	}
+
+	m_spout->SendTexture(textureHandle, GL_TEXTURE_2D, m_width, m_height, true, host_fbo);
+
+	state.framebuffer[0] = host_fbo;
+	state.framebuffer[1] = host_fbo;
 }
 #undef m_spout
 
-void interop::TextureSender::send(glFramebuffer& fb) {
-	this->send(fb.m_glTextureRGBA8, fb.m_width, fb.m_height);
+// spout shares the whole storage of the framebuffer, so resizing within its capacity keeps
+// the sender as it is. the header of the image tells receivers the regions at the logical size.
+// the network sender streams the logical size only
+uint interop::TextureSender::sharedWidth(const glFramebuffer& fb) const {
+	return (m_protocol == ImageProtocol::Network) ? fb.m_width : fb.m_capacityWidth;
+}
+
+uint interop::TextureSender::sharedHeight(const glFramebuffer& fb) const {
+	return (m_protocol == ImageProtocol::Network) ? fb.m_height : fb.m_capacityHeight;
+}
+
+void interop::TextureSender::send(glFramebuffer& fb) {
+	this->send(fb.m_glTextureRGBA8, this->sharedWidth(fb), this->sharedHeight(fb));
 }
 
 #define m_spout (static_cast<SpoutReceiver *>(m_receiver.get()))
@@ -391,15 +1662,34 @@ interop::TextureReceiver::TextureReceiver() {
 
 interop::TextureReceiver::~TextureReceiver() { m_receiver = nullptr; }
 
-void interop::TextureReceiver::init(ImageType type, std::string name) {
-	this->init(name + to_string(type));
+void interop::TextureReceiver::init(ImageType type, std::string name, ReceiveMode receive_mode) {
+	this->init(name + to_string(type), receive_mode);
 }
 
-void interop::TextureReceiver::init(std::string name) {
+void interop::TextureReceiver::init(std::string name, ReceiveMode receive_mode) {
 	if (name.size() == 0 || name.size() > 256)
 		return;
 
+	m_mode = receive_mode;
+
 	m_name = texture_sharing_address + name;
+
+	if (session_texture_sharing == ImageProtocol::Network) {
+		const auto address = networkImageAddress();
+		auto network = std::make_shared<NetworkImageReceiver>();
+		network->topic = m_name;
+		network->start(address);
+		m_receiver = network;
+		m_protocol = ImageProtocol::Network;
+		m_frame_sequence = 0;
+		m_dropped_frames = 0;
+		std::cout << "mint: receiving network image " << m_name << " from " << address << std::endl;
+		return;
+	}
+	if (m_protocol == ImageProtocol::Network)
+		m_receiver = std::make_shared<SpoutReceiver>();
+	m_protocol = session_texture_sharing;
+
 	m_name.resize(256, '\0'); // Spout doc says sender name MUST have 256 bytes
 
 	m_spout->SetVerticalSync(0);
@@ -425,7 +1715,10 @@ void interop::TextureReceiver::destroy() {
 	if (!m_receiver)
 		return;
 
-	m_spout->ReleaseReceiver();
+	if (m_protocol == ImageProtocol::Network)
+		static_cast<NetworkImageReceiver*>(m_receiver.get())->stop();
+	else
+		m_spout->ReleaseReceiver();
 }
 
 bool interop::TextureReceiver::receive() {
@@ -438,6 +1731,7 @@ bool interop::TextureReceiver::receive() {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		m_attached_texture = 0; // storage changed, re-check source fbo on next blit
 		};
 
 	glFramebuffer fbo_backup;
@@ -448,128 +1742,2072 @@ bool interop::TextureReceiver::receive() {
 		make_texture();
 	}
 
+	// in Texture mode we let spout do a plain copy without inverting,
+	// consumers account for the y-flip when sampling via m_flip_y
+	const bool blit = m_mode == ReceiveMode::Blit;
+	const bool invert = blit;
+
+	if (m_protocol == ImageProtocol::Network) {
+		// network frames keep the rows of the sender texture, patch the tiles changed since the last receive
+		auto& network = *static_cast<NetworkImageReceiver*>(m_receiver.get());
+		std::lock_guard<std::mutex> lock(network.mutex);
+		if (!network.fresh) {
+			restorePreviousFbo(&fbo_backup);
+			return false;
+		}
+
+		auto& frame = network.latest;
+		if (m_width != frame.width || m_height != frame.height) {
+			m_width = frame.width;
+			m_height = frame.height;
+			make_texture();
+			frame.dirty.assign(frame.dirty.size(), ~0u);
+		}
+
+		// one upload per run of dirty tiles in a tile row
+		const uint tiles_x = (m_width + network_tile_size - 1) / network_tile_size;
+		const uint tiles = networkTileCount(network_tile_size, m_width, m_height);
+		m_frame_tiles = 0;
+		glBindTexture(GL_TEXTURE_2D, m_texture_handle);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, m_width);
+		for (uint first = 0; first < tiles; first++) {
+			if (!isTileDirty(frame, first))
+				continue;
+			uint last = first;
+			while ((last + 1) % tiles_x != 0 && last + 1 < tiles && isTileDirty(frame, last + 1))
+				last++;
+
+			const auto begin = networkTile(first, network_tile_size, m_width, m_height);
+			const auto end = networkTile(last, network_tile_size, m_width, m_height);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, begin.x, begin.y, end.x + end.width - begin.x, begin.height,
+				GL_RGBA, GL_UNSIGNED_BYTE, frame.pixels.data() + static_cast<size_t>(begin.y) * m_width + begin.x);
+			m_frame_tiles += last - first + 1;
+			first = last;
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		frame.dirty.assign(frame.dirty.size(), 0u);
+		network.fresh = false;
+
+		// frames may be dropped by the sender, by zmq or by the receiver worker, count them all by sequence
+		if (m_frame_sequence && frame.sequence > m_frame_sequence)
+			m_dropped_frames += frame.sequence - m_frame_sequence - 1;
+		m_frame_sequence = frame.sequence;
+		m_frame_send_ns = frame.send_ns;
+		m_flip_y = false;
+	}
+	else {
+		// spout binds its own fbo for the copy and restores the host fbo afterwards
+		if (!m_spout->ReceiveTexture(const_cast<char*>(m_name.c_str()), width,
+			height
+			, m_texture_handle, GL_TEXTURE_2D, invert, fbo_backup.m_previousFramebuffer[0]
+		)) {
+			//std::cout << "SPOUT failed to receive texture" << std::endl;
+			restorePreviousFbo(&fbo_backup);
+			return false;
+		}
+
+		if (m_width != width || m_height != height) {
+			m_width = width;
+			m_height = height;
+			make_texture();
+		}
+
+		m_flip_y = !invert;
+	}
+
+	if (!blit) {
+		restorePreviousFbo(&fbo_backup);
+		return true;
+	}
+
 	if (!m_source_fbo) {
 		mglGenFramebuffersEXT(1, &m_source_fbo);
 		mglGenFramebuffersEXT(1, &m_target_fbo);
 	}
 
-	//bool connected = false;
-	//if (!m_spout->CheckReceiver(const_cast<char*>(m_name.c_str()), width,
-	//	height, connected) && session_texture_sharing == mint::ImageProtocol::GPU) {
-	//	std::cout << "SPOUT receive texture failed check, connected? " << (connected ? "yes" : "no") << std::endl;
-	//	std::cout << "SPOUT: name: " << m_name << ", width: " << width << ", height: " << height << std::endl;
-	//	return;
-	//}
+	// attach and validate the source fbo only when the texture changed, not every frame
+	if (m_attached_texture != m_texture_handle) {
+		bindFramebuffer(GL_FRAMEBUFFER_EXT, m_source_fbo);
+		mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+			GL_TEXTURE_2D, m_texture_handle, 0);
+
+		GLenum e = mglCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+		if (e != GL_FRAMEBUFFER_COMPLETE_EXT)
+			printf("There is a problem with the FBO\n");
+		else
+			m_attached_texture = m_texture_handle;
+	}
 
-	if (!m_spout->ReceiveTexture(const_cast<char*>(m_name.c_str()), width,
-		height
-		, m_texture_handle, GL_TEXTURE_2D, true /*invert*/, 0
-	)) {
-		//std::cout << "SPOUT failed to receive texture" << std::endl;
-		return false;
+	bindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, fbo_backup.m_previousFramebuffer[0]);
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, m_source_fbo);
+
+	// flip y axis of dx texture, network images are already upright
+	const uint source_top = m_protocol == ImageProtocol::Network ? m_height : 0;
+	mglBlitFramebufferEXT(0, m_height - source_top, m_width, source_top, 0, 0, m_width, m_height,
+		GL_COLOR_BUFFER_BIT, //| GL_DEPTH_BUFFER_BIT,
+		GL_NEAREST);
+
+	restorePreviousFbo(&fbo_backup);
+
+	return true;
+}
+#undef m_spout
+
+uint interop::StereoPackingFormat::encode() const {
+	return (static_cast<uint>(depth_encoding) & 0xF)
+		| ((static_cast<uint>(depth_resolution) & 0xF) << 4)
+		| ((static_cast<uint>(layout) & 0xF) << 8)
+		| ((static_cast<uint>(color_encoding) & 0xF) << 12);
+}
+
+interop::StereoPackingFormat interop::StereoPackingFormat::decode(const uint word) {
+	StereoPackingFormat format;
+	format.depth_encoding = static_cast<DepthEncoding>(word & 0xF);
+	format.depth_resolution = static_cast<DepthResolution>((word >> 4) & 0xF);
+	format.layout = static_cast<StereoLayout>((word >> 8) & 0xF);
+	format.color_encoding = static_cast<ColorEncoding>((word >> 12) & 0xF);
+	return format;
+}
+
+static bool layoutHasColor(const interop::StereoLayout layout) {
+	return layout != interop::StereoLayout::DepthOnly;
+}
+
+static bool layoutHasDepth(const interop::StereoLayout layout) {
+	return layout == interop::StereoLayout::ColorDepth || layout == interop::StereoLayout::DepthOnly;
+}
+
+static uint depthSampleBits(const interop::DepthEncoding encoding) {
+	switch (encoding) {
+	case interop::DepthEncoding::Linear24:
+		return 24;
+	case interop::DepthEncoding::Linear16:
+		return 16;
+	default:
+		return 32;
 	}
+}
 
-	if (m_width != width || m_height != height) {
-		m_width = width;
-		m_height = height;
-		make_texture();
+// depth samples of one view and the rows of a width pixels wide region storing them
+static uint depthRows(const interop::StereoPackingFormat& format, const uint width, const uint height,
+	uint& samples_x, uint& samples_y) {
+	const uint reduction = static_cast<uint>(format.depth_resolution);
+	samples_x = (width + reduction - 1) / reduction;
+	samples_y = (height + reduction - 1) / reduction;
+
+	// the samples are a bit stream over the 32 bit pixels, a 24 bit sample may span two pixels
+	const uint sample_bits = depthSampleBits(format.depth_encoding);
+	const uint depth_pixels = static_cast<uint>((static_cast<unsigned long long>(samples_x) * samples_y * sample_bits + 31) / 32);
+	return (depth_pixels + width - 1) / width;
+}
+
+// packed pixels of one 4x4 block of a block color encoding
+static uint colorBlockPixels(const interop::ColorEncoding encoding) {
+	return (encoding == interop::ColorEncoding::BC1) ? 2 : 4;
+}
+
+// bytes of each YUV420 plane of one view
+static uint lumaBytes(const uint width, const uint height) {
+	return width * height;
+}
+
+static uint chromaBytes(const uint width, const uint height) {
+	return ((width + 1) / 2) * ((height + 1) / 2);
+}
+
+// rows of a width pixels wide region storing the color of one view, see ColorEncoding
+static uint colorRows(const interop::StereoPackingFormat& format, const uint width, const uint height) {
+	uint pixels = 0;
+	switch (format.color_encoding) {
+	case interop::ColorEncoding::RGBA8:
+		return height;
+	case interop::ColorEncoding::YUV420:
+		pixels = (lumaBytes(width, height) + 2 * chromaBytes(width, height) + 3) / 4;
+		break;
+	default:
+		pixels = ((width + 3) / 4) * ((height + 3) / 4) * colorBlockPixels(format.color_encoding);
+		break;
 	}
+	return (pixels + width - 1) / width;
+}
 
-	//std::cout << "SPOUT: reports texture: with: " << m_width << ", height: " << m_height << ", handle: " << m_texture_handle << ", name: " << m_name.c_str() << std::endl;
+// color of pixel (x, y) of a view whose color region in the packed image is rect, as r: bits 0..7, ..., a: bits 24..31.
+// CPU counterpart of the decoding in StereoTextureReceiver
+static uint packedColor(const uint* image, const uint image_width, const interop::Rect& rect,
+	const interop::StereoPackingFormat& format, const uint view_width, const uint view_height, const uint x, const uint y) {
+	const auto pixel = [&](const uint i) { return image[(rect.y + i / rect.width) * image_width + rect.x + i % rect.width]; };
+	if (format.color_encoding == interop::ColorEncoding::RGBA8)
+		return pixel(y * rect.width + x);
+
+	const auto toRGBA8 = [](const float* rgb) {
+		uint result = 0xFF000000;
+		for (int i = 0; i < 3; i++) {
+			const float c = (rgb[i] < 0.0f) ? 0.0f : (rgb[i] > 1.0f) ? 1.0f : rgb[i];
+			result |= static_cast<uint>(c * 255.0f + 0.5f) << (8 * i);
+		}
+		return result;
+		};
 
-	//if (!m_spout->BindSharedTexture())
-	//	return;
+	if (format.color_encoding == interop::ColorEncoding::YUV420) {
+		const auto byte = [&](const uint b) { return ((pixel(b / 4) >> (8 * (b % 4))) & 0xFF) / 255.0f; };
+		const uint chroma = (y / 2) * ((view_width + 1) / 2) + x / 2;
+		const float luma = byte(y * view_width + x);
+		const float u = byte(lumaBytes(view_width, view_height) + chroma) - 0.5f;
+		const float v = byte(lumaBytes(view_width, view_height) + chromaBytes(view_width, view_height) + chroma) - 0.5f;
+		const float rgb[3] = { luma + 1.403f * v, luma - 0.344f * u - 0.714f * v, luma + 1.773f * u };
+		return toRGBA8(rgb);
+	}
 
-	//int shared_texture_id = 0;
-	//glGetIntegerv(GL_TEXTURE_BINDING_2D, &shared_texture_id);
-	mglBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_source_fbo);
-	mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
-		GL_TEXTURE_2D, m_texture_handle, 0);
+	const uint block_pixels = colorBlockPixels(format.color_encoding);
+	const uint first = ((y / 4) * ((view_width + 3) / 4) + x / 4) * block_pixels;
+	uint words[4] = { 0 };
+	for (uint k = 0; k < block_pixels; k++)
+		words[k] = pixel(first + k);
+	const uint texel = (y % 4) * 4 + x % 4;
+
+	// the color part is the last 8 bytes of a block
+	const uint c0 = words[block_pixels - 2] & 0xFFFF;
+	const uint c1 = words[block_pixels - 2] >> 16;
+	const uint index = (words[block_pixels - 1] >> (2 * texel)) & 0x3;
+	const auto rgb565 = [](const uint c, float* rgb) {
+		rgb[0] = ((c >> 11) & 0x1F) / 31.0f;
+		rgb[1] = ((c >> 5) & 0x3F) / 63.0f;
+		rgb[2] = (c & 0x1F) / 31.0f;
+		};
+	float e0[3], e1[3], rgb[3];
+	rgb565(c0, e0);
+	rgb565(c1, e1);
+	for (int i = 0; i < 3; i++) {
+		const float weights_4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		const float weights_3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+		const float w = (c0 > c1) ? weights_4[index] : weights_3[index];
+		rgb[i] = (c0 <= c1 && index == 3) ? 0.0f : w * e0[i] + (1.0f - w) * e1[i];
+	}
 
-	GLenum e = mglCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-	if (e != GL_FRAMEBUFFER_COMPLETE_EXT)
-		printf("There is a problem with the FBO\n");
+	if (format.color_encoding == interop::ColorEncoding::YCoCgDXT5) {
+		// Y in the alpha part, 3 bit indices following the 8 bit end points
+		const unsigned long long alpha_bits = (words[0] >> 16) | (static_cast<unsigned long long>(words[1]) << 16);
+		const float a0 = (words[0] & 0xFF) / 255.0f;
+		const float a1 = ((words[0] >> 8) & 0xFF) / 255.0f;
+		const uint a_index = static_cast<uint>((alpha_bits >> (3 * texel)) & 0x7);
+		float luma = 0.0f;
+		if (a_index < 2)
+			luma = (a_index == 0) ? a0 : a1;
+		else if (a0 > a1)
+			luma = ((8 - a_index) * a0 + (a_index - 1) * a1) / 7.0f;
+		else
+			luma = (a_index >= 6) ? (a_index - 6) * 1.0f : ((6 - a_index) * a0 + (a_index - 1) * a1) / 5.0f;
+
+		const float scale = static_cast<float>((c0 & 0x1F) + 1);
+		const float co = (rgb[0] - 0.5f) / scale;
+		const float cg = (rgb[1] - 0.5f) / scale;
+		rgb[0] = luma + co - cg;
+		rgb[1] = luma + cg;
+		rgb[2] = luma - co - cg;
+	}
 
-	//mglBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo_backup.m_previousFramebuffer[0]);
-	//mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
-	//	GL_TEXTURE_2D, m_texture_handle, 0);
-	e = mglCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-	if (e != GL_FRAMEBUFFER_COMPLETE_EXT)
-		printf("There is a problem with the FBO\n");
+	return toRGBA8(rgb);
+}
 
-	mglBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, fbo_backup.m_previousFramebuffer[0]);
-	mglBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, m_source_fbo);
+// header rows first from y = 0, image content above. see FrameMetadata
+static uint headerRows(const uint view_count, const uint image_width) {
+	return (interop::FrameMetadata::words(view_count) + image_width - 1) / image_width;
+}
 
-	// flip y axis of dx texture
-	mglBlitFramebufferEXT(0, m_height, m_width, 0, 0, 0, m_width, m_height,
-		GL_COLOR_BUFFER_BIT, //| GL_DEPTH_BUFFER_BIT,
-		GL_NEAREST);
+// writes the metadata followed by the view table into the header rows of the packed image.
+// the words run along rows of the shared texture width, which receivers see and index by.
+// it is never smaller than the image width, so the words fit the header rows
+static void uploadHeader(interop::glFramebuffer& fbo, std::vector<uint>& pixels,
+	const interop::FrameMetadata& metadata, const interop::ViewMetadata* views,
+	const uint row_width, const uint header_rows) {
+	pixels.assign(row_width * header_rows, 0);
+	std::memcpy(pixels.data(), &metadata, sizeof(interop::FrameMetadata));
+	std::memcpy(pixels.data() + metadata.views_offset, views, metadata.view_count * sizeof(interop::ViewMetadata));
+
+	// the header pixels store the words in memory order, r = bits 0..7 on little endian machines
+	const GLint previous_active_texture = bindScratchTexture(fbo.m_glTextureRGBA8);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, row_width, header_rows,
+		GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	unbindScratchTexture(previous_active_texture);
+}
 
-	mglBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	//m_spout->UnBindSharedTexture();
+interop::StereoPacking interop::StereoPacking::make(const StereoPackingFormat& format, const uint width, const uint height) {
+	StereoPacking p;
+	p.format = format;
+	p.width = width;
+	p.height = height;
+
+	const uint depth_rows = depthRows(format, width, height, p.depth_samples_x, p.depth_samples_y);
+	const uint color_rows = colorRows(format, width, height);
+
+	switch (format.layout) {
+	case StereoLayout::ColorDepth:
+		p.color[0] = Rect{ 0, 0, width, color_rows };
+		p.color[1] = Rect{ width, 0, width, color_rows };
+		p.depth[0] = Rect{ 0, color_rows, width, depth_rows };
+		p.depth[1] = Rect{ width, color_rows, width, depth_rows };
+		p.image_width = 2 * width;
+		p.image_height = color_rows + depth_rows;
+		break;
+	case StereoLayout::ColorSideBySide:
+		p.color[0] = Rect{ 0, 0, width, color_rows };
+		p.color[1] = Rect{ width, 0, width, color_rows };
+		p.image_width = 2 * width;
+		p.image_height = color_rows;
+		break;
+	case StereoLayout::ColorTopBottom:
+		p.color[0] = Rect{ 0, 0, width, color_rows };
+		p.color[1] = Rect{ 0, color_rows, width, color_rows };
+		p.image_width = width;
+		p.image_height = 2 * color_rows;
+		break;
+	case StereoLayout::DepthOnly:
+		p.depth[0] = Rect{ 0, 0, width, depth_rows };
+		p.depth[1] = Rect{ width, 0, width, depth_rows };
+		p.image_width = 2 * width;
+		p.image_height = depth_rows;
+		break;
+	default:
+		break;
+	}
+
+	p.header_rows = headerRows(2, p.image_width);
+	p.image_height += p.header_rows;
+	for (Rect* r : { &p.color[0], &p.color[1], &p.depth[0], &p.depth[1] })
+		if (r->width > 0)
+			r->y += p.header_rows;
+
+	return p;
+}
+
+bool interop::StereoPacking::hasColor() const {
+	return layoutHasColor(format.layout);
+}
+
+bool interop::StereoPacking::hasDepth() const {
+	return layoutHasDepth(format.layout);
+}
+
+interop::MultiViewPacking interop::MultiViewPacking::make(const StereoPackingFormat& format, const uint view_count,
+	const uint width, const uint height) {
+	MultiViewPacking p;
+	p.format = format;
+	p.view_count = view_count;
+	p.width = width;
+	p.height = height;
+
+	const uint depth_rows = depthRows(format, width, height, p.depth_samples_x, p.depth_samples_y);
+	const uint color_height = layoutHasColor(format.layout) ? colorRows(format, width, height) : 0;
+	const uint depth_height = layoutHasDepth(format.layout) ? depth_rows : 0;
+	const uint tile_height = color_height + depth_height;
+
+	// squarish grid, keeps the atlas within texture size limits for many views
+	p.columns = 1;
+	while (p.columns * p.columns < view_count)
+		p.columns++;
+	p.rows = (view_count + p.columns - 1) / p.columns;
+	p.image_width = p.columns * width;
+	p.header_rows = headerRows(view_count, p.image_width);
+	p.image_height = p.header_rows + p.rows * tile_height;
+
+	p.color.assign(view_count, Rect{});
+	p.depth.assign(view_count, Rect{});
+	for (uint v = 0; v < view_count; v++) {
+		const uint x = (v % p.columns) * width;
+		const uint y = p.header_rows + (v / p.columns) * tile_height;
+		if (color_height > 0)
+			p.color[v] = Rect{ x, y, width, color_height };
+		if (depth_height > 0)
+			p.depth[v] = Rect{ x, y + color_height, width, depth_height };
+	}
+
+	return p;
+}
+
+interop::StereoPacking interop::MultiViewPacking::pair(const uint first_view) const {
+	StereoPacking p;
+	p.format = format;
+	p.width = width;
+	p.height = height;
+	p.depth_samples_x = depth_samples_x;
+	p.depth_samples_y = depth_samples_y;
+	p.image_width = image_width;
+	p.image_height = image_height;
+	p.header_rows = header_rows;
+	for (uint i = 0; i < 2; i++) {
+		if (first_view + i < view_count) {
+			p.color[i] = color[first_view + i];
+			p.depth[i] = depth[first_view + i];
+		}
+	}
+	return p;
+}
+
+// the inset and the periphery of a foveated eye image start on color blocks and the coarsest depth
+// samples, so the packed blocks and samples never mix both
+static const uint foveation_alignment = 4;
+
+static uint alignFoveation(const uint value) {
+	return (value + foveation_alignment - 1) / foveation_alignment * foveation_alignment;
+}
+
+// inset of a foveated eye image, centered on the gaze point and kept inside the image
+static interop::Rect foveationInset(const interop::Foveation& foveation, const uint eye,
+	const uint width, const uint height) {
+	const auto extent = [&](const uint size) {
+		const uint e = alignFoveation(static_cast<uint>(foveation.inset_size * size + 0.5f));
+		return (e < 1) ? 1 : (e > size ? size : e);
+		};
+	const auto offset = [](const float gaze, const uint size, const uint extent) {
+		const int o = static_cast<int>(gaze * size) - static_cast<int>(extent / 2);
+		const int last = static_cast<int>(size - extent);
+		const uint clamped = static_cast<uint>((o < 0) ? 0 : (o > last ? last : o));
+		return clamped / foveation_alignment * foveation_alignment;
+		};
+
+	interop::Rect inset;
+	inset.width = extent(width);
+	inset.height = extent(height);
+	inset.x = offset(foveation.gaze_x[eye], width, inset.width);
+	inset.y = offset(foveation.gaze_y[eye], height, inset.height);
+	return inset;
+}
+
+// size of a foveated eye image: the downsampled periphery with the inset to its right
+static void foveatedSize(const interop::Foveation& foveation, const uint width, const uint height,
+	uint& foveated_width, uint& foveated_height) {
+	const uint scale = foveation.periphery_scale;
+	const interop::Rect inset = foveationInset(foveation, 0, width, height);
+	const uint periphery_height = (height + scale - 1) / scale;
+	foveated_width = alignFoveation((width + scale - 1) / scale) + inset.width;
+	foveated_height = (periphery_height > inset.height) ? periphery_height : inset.height;
+}
+
+interop::StereoTextureSender::StereoTextureSender() {}
+interop::StereoTextureSender::~StereoTextureSender() {}
+
+void interop::StereoTextureSender::init(std::string name, uint width, uint height, const StereoPackingFormat format) {
+
+	m_width = width;
+	m_height = height;
+	m_format = format;
+
+	for (glFramebuffer& target : m_hugeFbos)
+		target.init();
+	m_hugeTextureSender.init(interop::ImageType::SingleStereo, name, width, height);
+	m_packer.init(m_format.layout);
+
+	this->makeHugeTexture(m_width, m_height);
+}
+
+void interop::StereoTextureSender::setPackingFormat(const StereoPackingFormat format) {
+	m_format = format;
+	m_packer.setLayout(m_format.layout);
+	this->makeHugeTexture(m_width, m_height);
+}
+
+void interop::StereoTextureSender::setDepthRange(const float near_plane, const float far_plane) {
+	m_depthNear = near_plane;
+	m_depthFar = far_plane;
+}
+
+void interop::StereoTextureSender::setFrameCameras(const mat4& view_left, const mat4& projection_left,
+	const mat4& view_right, const mat4& projection_right) {
+	m_view[0] = view_left;
+	m_view[1] = view_right;
+	m_projection[0] = projection_left;
+	m_projection[1] = projection_right;
+}
+
+void interop::StereoTextureSender::setRenderStart(const unsigned long long render_start_ns) {
+	m_renderStartNs = render_start_ns;
+}
+
+void interop::StereoTextureSender::setRenderScale(const float render_scale) {
+	m_renderScale = render_scale;
+}
+
+void interop::StereoTextureSender::setRefinement(const uint level, const uint levels) {
+	m_refinementLevel = level;
+	m_refinementLevels = levels;
+}
+
+void interop::StereoTextureSender::setPredictionHorizon(const float prediction_ms) {
+	m_predictionMs = prediction_ms;
+}
+
+void interop::StereoTextureSender::setPackingPath(const PackingPath path) {
+	m_packer.setPath(path);
+}
+
+void interop::StereoTextureSender::setFoveation(const Foveation& foveation) {
+	const bool resize = foveation.periphery_scale != m_foveation.periphery_scale
+		|| foveation.inset_size != m_foveation.inset_size;
+	m_foveation = foveation;
+	if (resize)
+		this->makeHugeTexture(m_width, m_height);
+}
+
+bool interop::StereoTextureSender::isFoveated() const {
+	return m_foveation.periphery_scale > 1;
+}
+
+float interop::StereoTextureSender::getPackGpuMs() const {
+	return m_packer.getGpuMs();
+}
+
+uint interop::StereoTextureSender::getTargetWaits() const {
+	return m_targetWaits;
+}
+
+void interop::StereoTextureSender::destroy() {
+	for (uint i = 0; i < packed_targets; i++) {
+		if (m_targetFences[i])
+			mglDeleteSync(m_targetFences[i]);
+		m_targetFences[i] = nullptr;
+		m_hugeFbos[i].destroy();
+	}
+	for (glFramebuffer& fbo : m_foveatedFbos)
+		fbo.destroy();
+	if (m_foveationShader)
+		mglDeleteProgram(m_foveationShader);
+	m_foveationShader = 0;
+	m_hugeTextureSender.destroy();
+	m_packer.destroy();
+}
+
+void interop::StereoTextureSender::makeHugeTexture(const uint originalWidth,
+	const uint originalHeight) {
+	m_width = originalWidth;
+	m_height = originalHeight;
+
+	// foveation packs its reduced eye images instead of the original ones
+	uint eye_width = originalWidth;
+	uint eye_height = originalHeight;
+	if (this->isFoveated()) {
+		foveatedSize(m_foveation, originalWidth, originalHeight, eye_width, eye_height);
+		for (glFramebuffer& fbo : m_foveatedFbos)
+			fbo.resizeTexture(eye_width, eye_height);
+	}
+
+	m_packing = StereoPacking::make(m_format, eye_width, eye_height);
+	m_hugeWidth = m_packing.image_width;
+	m_hugeHeight = m_packing.image_height;
+
+	// only reallocates when the capacity of the huge fbos is exceeded, the sender follows the shared size.
+	// the targets are resized alike, so they share the same size
+	for (glFramebuffer& target : m_hugeFbos)
+		target.resizeTexture(m_hugeWidth, m_hugeHeight);
+	m_hugeTextureSender.resize(m_hugeTextureSender.sharedWidth(m_hugeFbos[0]),
+		m_hugeTextureSender.sharedHeight(m_hugeFbos[0]));
+}
+
+void interop::StereoTextureSender::send(glFramebuffer& fb_left,
+	glFramebuffer& fb_right,
+	const uint width,
+	const uint height,
+	const uint meta_data, const uint meta_data_2) {
+	this->send(fb_left.m_glTextureRGBA8, fb_right.m_glTextureRGBA8,
+		fb_left.m_glTextureDepth, fb_right.m_glTextureDepth,
+		width, height, meta_data, meta_data_2);
+}
+
+void interop::StereoTextureSender::send(
+	const uint color_left, const uint color_right, const uint depth_left,
+	const uint depth_right, const uint width, const uint height,
+	const uint meta_data, const uint meta_data_2) {
+	if (m_width != width || m_height != height)
+		this->makeHugeTexture(width, height);
+
+	uint color_textures[2] = { color_left, color_right };
+	uint depth_textures[2] = { depth_left, depth_right };
+
+	glFramebuffer& target = this->acquireTarget();
+	m_packer.beginTimer();
+	if (this->isFoveated()) {
+		this->foveate(color_textures, depth_textures);
+		for (int eye = 0; eye < 2; eye++) {
+			color_textures[eye] = m_foveatedFbos[eye].m_glTextureRGBA8;
+			depth_textures[eye] = m_foveatedFbos[eye].m_glTextureDepth;
+		}
+	}
+	m_packer.pack(target, m_packing, color_textures, depth_textures, m_depthNear, m_depthFar);
+	this->writeHeader(target, meta_data, meta_data_2);
+	m_packer.endTimer();
+
+	this->releaseTarget();
+}
+
+interop::glFramebuffer& interop::StereoTextureSender::beginRenderInPlace(const uint width, const uint height) {
+	if (m_width != width || m_height != height)
+		this->makeHugeTexture(width, height);
+
+	if (!m_packing.hasColor() || m_format.color_encoding != ColorEncoding::RGBA8)
+		std::cout << "mint: rendering in place needs a stereo layout with uncompressed color regions" << std::endl;
+	if (this->isFoveated())
+		std::cout << "mint: rendering in place does not support foveated packing" << std::endl;
+
+	return this->acquireTarget();
+}
+
+void interop::StereoTextureSender::sendInPlace(const uint meta_data, const uint meta_data_2) {
+	// the eyes were rendered at the color regions, so their depth lies there in the depth texture
+	glFramebuffer& target = this->acquireTarget(); // was already acquired by beginRenderInPlace()
+	m_packer.beginTimer();
+	m_packer.packDepth(target, m_packing, target.m_glTextureDepth, m_packing.color, m_depthNear, m_depthFar);
+	this->writeHeader(target, meta_data, meta_data_2);
+	m_packer.endTimer();
+
+	this->releaseTarget();
+}
+
+float interop::StereoTextureSender::measureColorPsnr(const uint color_left) {
+	if (!m_packing.hasColor() || color_left == 0)
+		return 0.0f;
+
+	// reads on the scratch unit, so the texture bound on the active unit of the application survives
+	const auto readTexture = [](const uint texture, std::vector<uint>& pixels) -> uint {
+		GLint width = 0, height = 0;
+		const GLint previous_active_texture = bindScratchTexture(texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		pixels.resize(static_cast<size_t>(width) * height);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		unbindScratchTexture(previous_active_texture);
+		return static_cast<uint>(width);
+		};
+
+	// the latest frame went into the target before the current one
+	const glFramebuffer& latest = m_hugeFbos[(m_target + packed_targets - 1) % packed_targets];
+	std::vector<uint> packed, original;
+	const uint packed_width = readTexture(latest.m_glTextureRGBA8, packed);
+	const uint original_width = readTexture(this->isFoveated() ? m_foveatedFbos[0].m_glTextureRGBA8 : color_left, original);
+
+	double squared_error = 0.0;
+	for (uint y = 0; y < m_packing.height; y++)
+		for (uint x = 0; x < m_packing.width; x++) {
+			const uint a = packedColor(packed.data(), packed_width, m_packing.color[0], m_format, m_packing.width, m_packing.height, x, y);
+			const uint b = original[y * original_width + x];
+			for (int c = 0; c < 3; c++) {
+				const double d = static_cast<double>((a >> (8 * c)) & 0xFF) - static_cast<double>((b >> (8 * c)) & 0xFF);
+				squared_error += d * d;
+			}
+		}
+
+	const double mse = squared_error / (3.0 * m_packing.width * m_packing.height);
+	if (mse == 0.0)
+		return std::numeric_limits<float>::infinity();
+	return static_cast<float>(10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+void interop::StereoTextureSender::foveate(const uint color_textures[2], const uint depth_textures[2]) {
+	if (!m_foveationShader) {
+		const char* vertex_shader_source =
+			R"(
+	#version 400
+
+	const vec4 unitQuad[4] =
+	vec4[](
+		vec4(-1.0f, 1.0f, 0.0f, 1.0f),
+		vec4(-1.0f,-1.0f, 0.0f, 1.0f),
+		vec4( 1.0f, 1.0f, 0.0f, 1.0f),
+		vec4( 1.0f,-1.0f, 0.0f, 1.0f)
+	);
+
+	void main()
+	{
+	    gl_Position = unitQuad[gl_VertexID];
+	}
+)";
+
+		const char* fragment_shader_source =
+			R"(
+	#version 400
+
+	uniform sampler2D color_in;
+	uniform sampler2D depth_in;
+	uniform int scale; // Foveation::periphery_scale
+	uniform ivec4 inset; // in the eye image
+	uniform ivec2 eye_size;
+	uniform int periphery_width;
+
+	out vec4 FragColor;
+
+	void main()
+	{
+		ivec2 coord = ivec2(gl_FragCoord.xy);
+
+		// full resolution inset right of the periphery
+		if (coord.x >= periphery_width) {
+			ivec2 texel = inset.xy + ivec2(coord.x - periphery_width, coord.y);
+			FragColor = vec4(0.0);
+			gl_FragDepth = 1.0;
+			if (coord.y < inset.w) {
+				FragColor = texelFetch(color_in, texel, 0);
+				gl_FragDepth = texelFetch(depth_in, texel, 0).r;
+			}
+			return;
+		}
+
+		// box filtered color and closest depth of the eye texels under the periphery texel.
+		// texels past the eye image only pad the periphery to the inset
+		vec4 color = vec4(0.0);
+		float depth = 1.0;
+		int count = 0;
+		for (int y = 0; y < scale; y++)
+			for (int x = 0; x < scale; x++) {
+				ivec2 texel = coord * scale + ivec2(x, y);
+				if (texel.x < eye_size.x && texel.y < eye_size.y) {
+					color += texelFetch(color_in, texel, 0);
+					depth = min(depth, texelFetch(depth_in, texel, 0).r);
+					count++;
+				}
+			}
+		FragColor = (count > 0) ? color / float(count) : vec4(0.0);
+		gl_FragDepth = depth;
+	}
+)";
+
+		const uint vertex_shader = compileShader(GL_VERTEX_SHADER, { vertex_shader_source });
+		const uint fragment_shader = compileShader(GL_FRAGMENT_SHADER, { fragment_shader_source });
+		m_foveationShader = linkProgram(vertex_shader, fragment_shader);
+		const char* names[] = { "color_in", "depth_in", "scale", "inset", "eye_size", "periphery_width" };
+		for (int i = 0; i < 6; i++)
+			m_foveation_uniform_locations[i] = mglGetUniformLocation(m_foveationShader, names[i]);
+	}
+
+	const GLint previous_active_texture = getActiveTexture();
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
 
+	// depth is written with gl_FragDepth, which needs the depth test
+	const GlDepthState previous_depth = getDepthState();
+	setDepthState(write_depth_state);
+
+	const uint scale = m_foveation.periphery_scale;
+	mglUseProgram(m_foveationShader);
+	mglBindVertexArray(m_packer.m_vao); // attribute-less like the draws of the packer
+	mglUniform1i(m_foveation_uniform_locations[0], 0);
+	mglUniform1i(m_foveation_uniform_locations[1], 1);
+	mglUniform1i(m_foveation_uniform_locations[2], static_cast<int>(scale));
+	mglUniform2i(m_foveation_uniform_locations[4], static_cast<int>(m_width), static_cast<int>(m_height));
+	mglUniform1i(m_foveation_uniform_locations[5], static_cast<int>(alignFoveation((m_width + scale - 1) / scale)));
+
+	for (uint eye = 0; eye < 2; eye++) {
+		m_insets[eye] = foveationInset(m_foveation, eye, m_width, m_height);
+		const Rect& inset = m_insets[eye];
+		mglUniform4i(m_foveation_uniform_locations[3], static_cast<int>(inset.x), static_cast<int>(inset.y),
+			static_cast<int>(inset.width), static_cast<int>(inset.height));
+
+		setActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, color_textures[eye]);
+		setActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, depth_textures[eye]);
+
+		const glFramebuffer& target = m_foveatedFbos[eye];
+		bindFramebuffer(GL_FRAMEBUFFER_EXT, target.m_glFbo);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT);
+		setViewport(0, 0, target.m_width, target.m_height);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	setActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	mglBindVertexArray(0);
+	setDepthState(previous_depth);
 	restorePreviousFbo(&fbo_backup);
+	setActiveTexture(previous_active_texture);
+}
+
+interop::glFramebuffer& interop::StereoTextureSender::acquireTarget() {
+	void*& fence = m_targetFences[m_target];
+	if (fence) {
+		// usually signaled long ago, the other target was packed and shared in the meantime
+		GLenum status = mglClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			m_targetWaits++;
+			status = mglClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, target_wait_timeout_ns);
+		}
+		if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+			std::cout << "mint: packed stereo image " << m_target << " may still be in use by sharing" << std::endl;
+		mglDeleteSync(fence);
+		fence = nullptr;
+	}
+	return m_hugeFbos[m_target];
+}
+
+// the fence follows the copy of spout or the readback of the network sender, which read the
+// target on the GPU after send() returned. the next frame goes into the other target meanwhile
+void interop::StereoTextureSender::releaseTarget() {
+	m_hugeTextureSender.send(m_hugeFbos[m_target]);
+	m_targetFences[m_target] = mglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_target = (m_target + 1) % packed_targets;
+}
+
+void interop::StereoTextureSender::writeHeader(glFramebuffer& target, const uint meta_data, const uint meta_data_2) {
+	FrameMetadata& m = m_metadata;
+	m.magic = FrameMetadata::Magic;
+	m.version = FrameMetadata::CurrentVersion;
+	m.word_count = FrameMetadata::words(2);
+	m.steering_frame_id = meta_data;
+	m.user_data = meta_data_2;
+	m.frame_sequence++;
+	m.format = m_format.encode();
+	m.header_rows = m_packing.header_rows;
+	m.eye_width = m_packing.width;
+	m.eye_height = m_packing.height;
+	m.depth_near = m_depthNear;
+	m.depth_far = m_depthFar;
+	m.render_end_ns = nowNs();
+	m.render_start_ns = (m_renderStartNs != 0) ? m_renderStartNs : m.render_end_ns;
+	m_renderStartNs = 0; // the caller sets it again for the next frame
+	m.view_count = 2;
+	m.views_offset = FrameMetadata::words();
+	m.render_scale = m_renderScale;
+	m.refinement_level = m_refinementLevel;
+	m.refinement_levels = m_refinementLevels;
+	m.prediction_ms = m_predictionMs;
+	m.periphery_scale = this->isFoveated() ? m_foveation.periphery_scale : 0;
+	m.full_eye_width = m_width;
+	m.full_eye_height = m_height;
+
+	ViewMetadata views[2];
+	for (int eye = 0; eye < 2; eye++) {
+		m.inset[eye] = this->isFoveated() ? m_insets[eye] : Rect{};
+		m.color[eye] = views[eye].color = m_packing.color[eye];
+		m.depth[eye] = views[eye].depth = m_packing.depth[eye];
+		m.view[eye] = views[eye].view = m_view[eye];
+		m.projection[eye] = views[eye].projection = m_projection[eye];
+	}
+
+	uploadHeader(target, m_headerPixels, m, views, m_hugeTextureSender.sharedWidth(target), m_packing.header_rows);
+}
+
+void interop::MultiViewTextureSender::init(std::string name, const uint view_count,
+	const uint width, const uint height, const StereoPackingFormat format) {
+	m_format = format;
+
+	m_atlasFbo.init();
+	m_atlasSender.init(interop::ImageType::MultiView, name, width, height);
+	m_packer.init(m_format.layout);
+
+	this->makeAtlas(view_count, width, height);
+}
+
+void interop::MultiViewTextureSender::destroy() {
+	m_atlasFbo.destroy();
+	m_atlasSender.destroy();
+	m_packer.destroy();
+}
+
+void interop::MultiViewTextureSender::setPackingFormat(const StereoPackingFormat format) {
+	m_format = format;
+	m_packer.setLayout(m_format.layout);
+	this->makeAtlas(m_packing.view_count, m_width, m_height);
+}
+
+void interop::MultiViewTextureSender::setViewCount(const uint view_count) {
+	if (view_count != m_packing.view_count)
+		this->makeAtlas(view_count, m_width, m_height);
+}
+
+void interop::MultiViewTextureSender::setDepthRange(const float near_plane, const float far_plane) {
+	m_depthNear = near_plane;
+	m_depthFar = far_plane;
+}
+
+void interop::MultiViewTextureSender::setViewCamera(const uint view, const mat4& view_matrix, const mat4& projection) {
+	if (view >= m_views.size())
+		return;
+
+	m_views[view].view = view_matrix;
+	m_views[view].projection = projection;
+}
+
+void interop::MultiViewTextureSender::setRenderStart(const unsigned long long render_start_ns) {
+	m_renderStartNs = render_start_ns;
+}
+
+void interop::MultiViewTextureSender::setPackingPath(const PackingPath path) {
+	m_packer.setPath(path);
+}
+
+float interop::MultiViewTextureSender::getPackGpuMs() const {
+	return m_packer.getGpuMs();
+}
+
+void interop::MultiViewTextureSender::makeAtlas(const uint view_count, const uint width, const uint height) {
+	m_width = width;
+	m_height = height;
+	m_packing = MultiViewPacking::make(m_format, view_count, width, height);
+	m_views.resize(view_count); // keeps the cameras of existing views
+
+	// only reallocates when the capacity of the atlas fbo is exceeded, the sender follows the shared size
+	m_atlasFbo.resizeTexture(m_packing.image_width, m_packing.image_height);
+	m_atlasSender.resize(m_atlasSender.sharedWidth(m_atlasFbo), m_atlasSender.sharedHeight(m_atlasFbo));
+}
+
+void interop::MultiViewTextureSender::send(const std::vector<glFramebuffer*>& views,
+	const uint width, const uint height,
+	const uint meta_data, const uint meta_data_2) {
+	std::vector<uint> color_textures(views.size()), depth_textures(views.size());
+	for (size_t v = 0; v < views.size(); v++) {
+		color_textures[v] = views[v]->m_glTextureRGBA8;
+		depth_textures[v] = views[v]->m_glTextureDepth;
+	}
+	this->send(color_textures, depth_textures, width, height, meta_data, meta_data_2);
+}
+
+void interop::MultiViewTextureSender::send(const std::vector<uint>& color_textures,
+	const std::vector<uint>& depth_textures, const uint width, const uint height,
+	const uint meta_data, const uint meta_data_2) {
+	if (color_textures.size() != depth_textures.size()) {
+		std::cout << "mint: MultiViewTextureSender needs as many depth textures as color textures" << std::endl;
+		return;
+	}
+
+	const uint view_count = static_cast<uint>(color_textures.size());
+	if (view_count != m_packing.view_count || width != m_packing.width || height != m_packing.height)
+		this->makeAtlas(view_count, width, height);
+
+	// the packer handles two views per pass, the second one is missing for the last pair of an odd count
+	m_packer.beginTimer();
+	for (uint v = 0; v < view_count; v += 2) {
+		const uint second = (v + 1 < view_count) ? v + 1 : v;
+		const uint colors[2] = { color_textures[v], (second != v) ? color_textures[second] : 0 };
+		const uint depths[2] = { depth_textures[v], (second != v) ? depth_textures[second] : 0 };
+		m_packer.pack(m_atlasFbo, m_packing.pair(v), colors, depths, m_depthNear, m_depthFar);
+	}
+	this->writeHeader(meta_data, meta_data_2);
+	m_packer.endTimer();
+
+	m_atlasSender.send(m_atlasFbo);
+}
+
+void interop::MultiViewTextureSender::writeHeader(const uint meta_data, const uint meta_data_2) {
+	FrameMetadata& m = m_metadata;
+	m.magic = FrameMetadata::Magic;
+	m.version = FrameMetadata::CurrentVersion;
+	m.word_count = FrameMetadata::words(m_packing.view_count);
+	m.steering_frame_id = meta_data;
+	m.user_data = meta_data_2;
+	m.frame_sequence++;
+	m.format = m_format.encode();
+	m.header_rows = m_packing.header_rows;
+	m.eye_width = m_packing.width;
+	m.eye_height = m_packing.height;
+	m.depth_near = m_depthNear;
+	m.depth_far = m_depthFar;
+	m.render_end_ns = nowNs();
+	m.render_start_ns = (m_renderStartNs != 0) ? m_renderStartNs : m.render_end_ns;
+	m_renderStartNs = 0;
+	m.view_count = m_packing.view_count;
+	m.views_offset = FrameMetadata::words();
+
+	for (uint v = 0; v < m_packing.view_count; v++) {
+		m_views[v].color = m_packing.color[v];
+		m_views[v].depth = m_packing.depth[v];
+	}
+	for (uint eye = 0; eye < 2; eye++) {
+		const ViewMetadata view = (eye < m_packing.view_count) ? m_views[eye] : ViewMetadata{};
+		m.color[eye] = view.color;
+		m.depth[eye] = view.depth;
+		m.view[eye] = view.view;
+		m.projection[eye] = view.projection;
+	}
+
+	uploadHeader(m_atlasFbo, m_headerPixels, m, m_views.data(), m_atlasSender.sharedWidth(m_atlasFbo), m_packing.header_rows);
+}
+
+// FrameMetadata and, if views is given, the view table from header rows read back from a packed image.
+// false without a valid header
+static bool readFrameMetadata(const uint* pixels, const uint width, const uint rows, const bool flipped,
+	interop::FrameMetadata& metadata, std::vector<interop::ViewMetadata>* views = nullptr) {
+	// header words in sender row order, the rows were read bottom-up from a top-down image if flipped
+	std::vector<uint> words(width * rows);
+	for (uint r = 0; r < rows; r++)
+		std::memcpy(&words[r * width], &pixels[(flipped ? rows - 1 - r : r) * width], width * sizeof(uint));
+
+	if (words.size() < interop::FrameMetadata::words() || words[0] != interop::FrameMetadata::Magic)
+		return false;
+
+	// fields appended after the version of the sender keep their defaults. since version 2 the struct
+	// of the sender ends at views_offset, word_count includes the view table
+	const interop::FrameMetadata defaults;
+	const uint version = words[offsetof(interop::FrameMetadata, version) / sizeof(uint)];
+	const uint views_offset = (version >= 2) ? words[offsetof(interop::FrameMetadata, views_offset) / sizeof(uint)] : 0;
+	const uint sender_words = (views_offset > 0) ? views_offset : words[offsetof(interop::FrameMetadata, word_count) / sizeof(uint)];
+	const uint word_count = (sender_words < interop::FrameMetadata::words()) ? sender_words : interop::FrameMetadata::words();
+	std::memcpy(static_cast<void*>(&metadata), &defaults, sizeof(interop::FrameMetadata));
+	std::memcpy(static_cast<void*>(&metadata), words.data(), word_count * sizeof(uint));
+
+	if (views) {
+		// as much of the table as the rows hold
+		const uint view_words = interop::ViewMetadata::words();
+		views->clear();
+		for (uint v = 0; v < metadata.view_count && views_offset + (v + 1) * view_words <= words.size(); v++) {
+			views->emplace_back();
+			std::memcpy(static_cast<void*>(&views->back()), &words[views_offset + v * view_words], view_words * sizeof(uint));
+		}
+	}
+	return true;
+}
+
+void interop::StereoTextureReceiver::init(std::string name, const ImageType type) {
+	loadGlExtensions();
+	m_receiver.init(type, name, ReceiveMode::Texture);
+
+	const char* vertex_shader_source =
+		R"(
+	#version 400
+
+	const vec4 unitQuad[4] =
+	vec4[](
+		vec4(-1.0f, 1.0f, 0.0f, 1.0f),
+		vec4(-1.0f,-1.0f, 0.0f, 1.0f),
+		vec4( 1.0f, 1.0f, 0.0f, 1.0f),
+		vec4( 1.0f,-1.0f, 0.0f, 1.0f)
+	);
+
+	void main()
+	{
+	    gl_Position = unitQuad[gl_VertexID];
+	}
+)";
+
+	// word indices of the FrameMetadata fields the shader reads from the header rows
+	const auto word = [](const size_t offset) { return std::to_string(offset / sizeof(uint)); };
+	const std::string fragment_shader_header = "#version 400\n"
+		"#define MAGIC " + std::to_string(FrameMetadata::Magic) + "u\n"
+		"#define WORD_VERSION " + word(offsetof(FrameMetadata, version)) + "\n"
+		"#define WORD_FORMAT " + word(offsetof(FrameMetadata, format)) + "\n"
+		"#define WORD_EYE_WIDTH " + word(offsetof(FrameMetadata, eye_width)) + "\n"
+		"#define WORD_EYE_HEIGHT " + word(offsetof(FrameMetadata, eye_height)) + "\n"
+		"#define WORD_DEPTH_NEAR " + word(offsetof(FrameMetadata, depth_near)) + "\n"
+		"#define WORD_DEPTH_FAR " + word(offsetof(FrameMetadata, depth_far)) + "\n"
+		"#define WORD_COLOR " + word(offsetof(FrameMetadata, color)) + "\n"
+		"#define WORD_DEPTH " + word(offsetof(FrameMetadata, depth)) + "\n"
+		"#define WORD_PERIPHERY_SCALE " + word(offsetof(FrameMetadata, periphery_scale)) + "\n"
+		"#define WORD_FULL_EYE_WIDTH " + word(offsetof(FrameMetadata, full_eye_width)) + "\n"
+		"#define WORD_FULL_EYE_HEIGHT " + word(offsetof(FrameMetadata, full_eye_height)) + "\n"
+		"#define WORD_INSET " + word(offsetof(FrameMetadata, inset)) + "\n"
+		"#define WORD_VIEW_COUNT " + word(offsetof(FrameMetadata, view_count)) + "\n"
+		"#define WORD_VIEWS_OFFSET " + word(offsetof(FrameMetadata, views_offset)) + "\n"
+		"#define VIEW_WORDS " + std::to_string(ViewMetadata::words()) + "\n"
+		"#define VIEW_COLOR " + word(offsetof(ViewMetadata, color)) + "\n"
+		"#define VIEW_DEPTH " + word(offsetof(ViewMetadata, depth)) + "\n";
+
+	// reading the header rows, shared by the unpack and reconstruct passes
+	const char* fragment_shader_header_functions =
+		R"(
+	uniform sampler2D packed_image;
+	uniform bool flip_y; // rows of packed_image are stored top-down, see TextureReceiver::m_flip_y
+	uniform int packing_format; // the eye images were allocated for, of the header of an earlier frame
+	uniform ivec2 packing_size;
+
+	ivec2 packedCoord(ivec2 coord) {
+		return (flip_y) ? ivec2(coord.x, textureSize(packed_image, 0).y - 1 - coord.y) : coord;
+	}
+
+	uint packedWord(ivec2 coord) {
+		uvec4 b = uvec4(round(texelFetch(packed_image, packedCoord(coord), 0) * 255.0));
+		return b.r | (b.g << 8) | (b.b << 16) | (b.a << 24);
+	}
+
+	uint headerWord(int index) {
+		int width = textureSize(packed_image, 0).x;
+		return packedWord(ivec2(index % width, index / width));
+	}
+
+	ivec4 headerRect(int index) {
+		return ivec4(headerWord(index), headerWord(index + 1), headerWord(index + 2), headerWord(index + 3));
+	}
+
+	// false if the header of this frame needs other eye images than the ones allocated
+	bool headerMatches() {
+		return headerWord(0) == MAGIC && int(headerWord(WORD_FORMAT)) == packing_format
+			&& ivec2(headerWord(WORD_EYE_WIDTH), headerWord(WORD_EYE_HEIGHT)) == packing_size;
+	}
+
+	// VIEW_COLOR or VIEW_DEPTH rect of a view from the view table, from the eye fields without one
+	ivec4 viewRect(int view, int field) {
+		if (headerWord(WORD_VERSION) >= 2u && uint(view) < headerWord(WORD_VIEW_COUNT))
+			return headerRect(int(headerWord(WORD_VIEWS_OFFSET)) + view * VIEW_WORDS + field);
+		return headerRect(((field == VIEW_COLOR) ? WORD_COLOR : WORD_DEPTH) + 4 * view);
+	}
+)";
+
+	const char* fragment_shader_body =
+		R"(
+	uniform int view; // of the view table, m_firstView + eye
+	uniform bool unpack_depth; // color into FragColor, or depth into gl_FragDepth
+	uniform bool native_blocks; // the color blocks of the eye were uploaded into block_image
+	uniform sampler2D block_image;
+
+	out vec4 FragColor;
+
+	vec3 fromRGB565(uint c) {
+		return vec3((c >> 11) & 0x1Fu, (c >> 5) & 0x3Fu, c & 0x1Fu) / vec3(31.0, 63.0, 31.0);
+	}
+
+	// BC1 color part of a block, see ColorEncoding
+	vec3 decodeColorBlock(uint end_points, uint indices, int texel) {
+		uint c0 = end_points & 0xFFFFu;
+		uint c1 = end_points >> 16;
+		uint index = (indices >> (2 * texel)) & 0x3u;
+		vec3 e0 = fromRGB565(c0);
+		vec3 e1 = fromRGB565(c1);
+		if (index < 2u)
+			return (index == 0u) ? e0 : e1;
+		if (c0 > c1)
+			return (index == 2u) ? mix(e1, e0, 2.0 / 3.0) : mix(e1, e0, 1.0 / 3.0);
+		return (index == 2u) ? mix(e1, e0, 0.5) : vec3(0.0);
+	}
+
+	// DXT5 alpha part of a block
+	float decodeAlphaBlock(uint word0, uint word1, int texel) {
+		float a0 = float(word0 & 0xFFu) / 255.0;
+		float a1 = float((word0 >> 8) & 0xFFu) / 255.0;
+		int bit = 3 * texel;
+		uint index = (bit < 16)
+			? (word0 >> (16 + bit))
+			: (word1 >> (bit - 16));
+		if (bit == 15)
+			index |= word1 << 1;
+		index &= 0x7u;
+
+		if (index < 2u)
+			return (index == 0u) ? a0 : a1;
+		float i = float(index);
+		if (a0 > a1)
+			return ((8.0 - i) * a0 + (i - 1.0) * a1) / 7.0;
+		if (index >= 6u)
+			return i - 6.0;
+		return ((6.0 - i) * a0 + (i - 1.0) * a1) / 5.0;
+	}
+
+	// byte b of a region storing bytes, 4 per pixel
+	float packedByte(ivec4 rect, int b) {
+		int p = b / 4;
+		return texelFetch(packed_image, packedCoord(rect.xy + ivec2(p % rect.z, p / rect.z)), 0)[b % 4];
+	}
+
+	// color of pixel coord of the eye whose color region is rect, see StereoPacking
+	vec4 colorPixel(ivec4 rect, int encoding, ivec2 coord) {
+		if (encoding == 0)
+			return texelFetch(packed_image, packedCoord(rect.xy + coord), 0);
+
+		if (encoding == 3) {
+			ivec2 size = ivec2(headerWord(WORD_EYE_WIDTH), headerWord(WORD_EYE_HEIGHT));
+			ivec2 chroma_size = (size + ivec2(1)) / 2;
+			int chroma = (coord.y / 2) * chroma_size.x + coord.x / 2;
+			int luma_bytes = size.x * size.y;
+			float luma = packedByte(rect, coord.y * size.x + coord.x);
+			float u = packedByte(rect, luma_bytes + chroma) - 0.5;
+			float v = packedByte(rect, luma_bytes + chroma_size.x * chroma_size.y + chroma) - 0.5;
+			return vec4(clamp(vec3(luma + 1.403 * v, luma - 0.344 * u - 0.714 * v, luma + 1.773 * u), 0.0, 1.0), 1.0);
+		}
+
+		// rgb = color part, a = alpha part of the block, decoded by the GL if it was uploaded as it is
+		vec4 block = texelFetch(block_image, coord, 0);
+		if (!native_blocks) {
+			int block_pixels = (encoding == 1) ? 2 : 4;
+			int blocks_x = (int(headerWord(WORD_EYE_WIDTH)) + 3) / 4;
+			int first = ((coord.y / 4) * blocks_x + coord.x / 4) * block_pixels;
+			uint words[4];
+			for (int k = 0; k < block_pixels; k++) {
+				int p = first + k;
+				words[k] = packedWord(rect.xy + ivec2(p % rect.z, p / rect.z));
+			}
+			int texel = (coord.y % 4) * 4 + coord.x % 4;
+
+			// the color part is the last 8 bytes of a block
+			block.rgb = decodeColorBlock(words[block_pixels - 2], words[block_pixels - 1], texel);
+			block.a = (encoding == 1) ? 1.0 : decodeAlphaBlock(words[0], words[1], texel);
+		}
+		if (encoding == 1)
+			return vec4(block.rgb, 1.0);
+
+		// both end points hold scale - 1 in their blue, so every texel of the block does
+		float luma = block.a;
+		float scale = round(block.b * 31.0) + 1.0;
+		float co = (block.r - 0.5) / scale;
+		float cg = (block.g - 0.5) / scale;
+		return vec4(clamp(vec3(luma + co - cg, luma + cg, luma - co - cg), 0.0, 1.0), 1.0);
+	}
+
+	// inverse of the linear depth normalization of the sender
+	float windowDepth(float linear_depth) {
+		float n = uintBitsToFloat(headerWord(WORD_DEPTH_NEAR));
+		float f = uintBitsToFloat(headerWord(WORD_DEPTH_FAR));
+		float z_eye = n + linear_depth * (f - n);
+		float z_ndc = (f + n - 2.0 * n * f / z_eye) / (f - n);
+		return z_ndc * 0.5 + 0.5;
+	}
+
+	void main()
+	{
+		// the eye images keep the previous frame until they are allocated for this one
+		if (!headerMatches())
+			discard;
+
+		ivec2 coord = ivec2(gl_FragCoord.xy);
+
+		uint format = headerWord(WORD_FORMAT);
+
+		if (!unpack_depth) {
+			ivec4 rect = viewRect(view, VIEW_COLOR);
+			FragColor = colorPixel(rect, int((format >> 12) & 0xFu), coord);
+			return;
+		}
+
+		// one fragment per depth sample, see StereoPacking
+		ivec4 rect = viewRect(view, VIEW_DEPTH);
+		int encoding = int(format & 0xFu);
+		int resolution = int((format >> 4) & 0xFu);
+		int samples_x = (int(headerWord(WORD_EYE_WIDTH)) + resolution - 1) / resolution;
+		int sample_bits = (encoding == 0) ? 32 : (encoding == 1) ? 24 : 16;
+		int first_bit = (coord.y * samples_x + coord.x) * sample_bits;
+		int pixel = first_bit / 32;
+		int offset = first_bit % 32;
+		uint bits = packedWord(rect.xy + ivec2(pixel % rect.z, pixel / rect.z)) >> offset;
+		if (offset + sample_bits > 32) {
+			pixel += 1;
+			bits |= packedWord(rect.xy + ivec2(pixel % rect.z, pixel / rect.z)) << (32 - offset);
+		}
+
+		if (encoding == 0)
+			gl_FragDepth = uintBitsToFloat(bits);
+		else if (encoding == 1)
+			gl_FragDepth = windowDepth(float(bits & 0xFFFFFFu) / 16777215.0);
+		else
+			gl_FragDepth = windowDepth(float(bits & 0xFFFFu) / 65535.0);
+	}
+)";
+
+	// full size eye images from foveated ones, see Foveation
+	const char* reconstruct_shader_body =
+		R"(
+	uniform sampler2D foveated_color; // eye images as unpacked from the packed image
+	uniform sampler2D foveated_depth;
+	uniform int eye; // 0 = left, 1 = right
+	uniform bool reconstruct_depth; // color into FragColor, or depth into gl_FragDepth
+
+	out vec4 FragColor;
+
+	void main()
+	{
+		if (!headerMatches())
+			discard;
+
+		ivec2 coord = ivec2(gl_FragCoord.xy);
+
+		int scale = int(headerWord(WORD_PERIPHERY_SCALE));
+		ivec2 eye_size = ivec2(headerWord(WORD_FULL_EYE_WIDTH), headerWord(WORD_FULL_EYE_HEIGHT));
+		ivec2 periphery = (eye_size + ivec2(scale - 1)) / scale;
+		ivec4 inset = headerRect(WORD_INSET + 4 * eye);
+		// the inset ends the foveated image, the periphery may be padded to it
+		ivec2 inset_origin = ivec2(int(headerWord(WORD_EYE_WIDTH)) - inset.z, 0) - inset.xy;
+
+		if (reconstruct_depth) {
+			// nearest sample, one fragment per depth sample like the unpack pass
+			int resolution = int((headerWord(WORD_FORMAT) >> 4) & 0xFu);
+			ivec2 texel = coord * resolution;
+			bool in_inset = all(greaterThanEqual(texel, inset.xy)) && all(lessThan(texel, inset.xy + inset.zw));
+			ivec2 foveated = in_inset ? texel + inset_origin : texel / scale;
+			ivec2 last = textureSize(foveated_depth, 0) - ivec2(1);
+			gl_FragDepth = texelFetch(foveated_depth, min(foveated / resolution, last), 0).r;
+			return;
+		}
+
+		// bilinear periphery, kept off its border so the inset next to it does not bleed in
+		vec2 periphery_coord = clamp((vec2(coord) + 0.5) / float(scale), vec2(0.5), vec2(periphery) - 0.5);
+		FragColor = texture(foveated_color, periphery_coord / vec2(textureSize(foveated_color, 0)));
+
+		// the inset fades in over a few texels at borders inside the eye image
+		int feather = 2 * scale;
+		ivec2 low = coord - inset.xy;
+		ivec2 high = inset.xy + inset.zw - ivec2(1) - coord;
+		if (inset.x == 0)
+			low.x = feather;
+		if (inset.y == 0)
+			low.y = feather;
+		if (inset.x + inset.z >= eye_size.x)
+			high.x = feather;
+		if (inset.y + inset.w >= eye_size.y)
+			high.y = feather;
+		ivec2 distance = min(low, high);
+		int border = min(distance.x, distance.y);
+		if (border >= 0) {
+			vec4 inset_color = texelFetch(foveated_color, coord + inset_origin, 0);
+			FragColor = mix(FragColor, inset_color, min(float(border + 1) / float(feather), 1.0));
+		}
+	}
+)";
+
+	const uint vertex_shader = compileShader(GL_VERTEX_SHADER, { vertex_shader_source });
+	const uint fragment_shader = compileShader(GL_FRAGMENT_SHADER,
+		{ fragment_shader_header.c_str(), fragment_shader_header_functions, fragment_shader_body });
+	m_shader = linkProgram(vertex_shader, fragment_shader);
+	m_uniform_locations[0] = mglGetUniformLocation(m_shader, "packed_image");
+	m_uniform_locations[1] = mglGetUniformLocation(m_shader, "flip_y");
+	m_uniform_locations[2] = mglGetUniformLocation(m_shader, "view");
+	m_uniform_locations[3] = mglGetUniformLocation(m_shader, "unpack_depth");
+	m_uniform_locations[4] = mglGetUniformLocation(m_shader, "packing_format");
+	m_uniform_locations[5] = mglGetUniformLocation(m_shader, "packing_size");
+	m_uniform_locations[6] = mglGetUniformLocation(m_shader, "native_blocks");
+	m_uniform_locations[7] = mglGetUniformLocation(m_shader, "block_image");
+
+	// block encoded color only comes as bytes on the CPU over the network
+	GLint extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+	m_blockUpload = false;
+	for (GLint i = 0; i < extensions && m_receiver.m_protocol == ImageProtocol::Network; i++) {
+		const char* extension = reinterpret_cast<const char*>(mglGetStringi(GL_EXTENSIONS, i));
+		if (extension && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+			m_blockUpload = mglCompressedTexSubImage2D != nullptr;
+	}
+
+	const uint reconstruct_vertex_shader = compileShader(GL_VERTEX_SHADER, { vertex_shader_source });
+	const uint reconstruct_fragment_shader = compileShader(GL_FRAGMENT_SHADER,
+		{ fragment_shader_header.c_str(), fragment_shader_header_functions, reconstruct_shader_body });
+	m_reconstructShader = linkProgram(reconstruct_vertex_shader, reconstruct_fragment_shader);
+	const char* reconstruct_names[] = { "packed_image", "flip_y", "foveated_color", "foveated_depth", "eye", "reconstruct_depth",
+		"packing_format", "packing_size" };
+	for (int i = 0; i < 8; i++)
+		m_reconstruct_uniform_locations[i] = mglGetUniformLocation(m_reconstructShader, reconstruct_names[i]);
+
+	mglGenVertexArrays(1, &m_vao);
+	mglGenFramebuffersEXT(1, &m_packedFbo);
+	mglGenFramebuffersEXT(2, m_colorFbos);
+	mglGenFramebuffersEXT(2, m_depthFbos);
+	mglGenFramebuffersEXT(2, m_foveatedColorFbos);
+	mglGenFramebuffersEXT(2, m_foveatedDepthFbos);
+	mglGenBuffers(1, &m_headerPbo);
+}
+
+void interop::StereoTextureReceiver::destroy() {
+	m_receiver.destroy();
+	this->deleteTextures();
+	if (m_shader)
+		mglDeleteProgram(m_shader);
+	if (m_reconstructShader)
+		mglDeleteProgram(m_reconstructShader);
+	if (m_vao)
+		mglDeleteVertexArrays(1, &m_vao);
+	if (m_packedFbo) {
+		mglDeleteFramebuffersEXT(1, &m_packedFbo);
+		mglDeleteFramebuffersEXT(2, m_colorFbos);
+		mglDeleteFramebuffersEXT(2, m_depthFbos);
+		mglDeleteFramebuffersEXT(2, m_foveatedColorFbos);
+		mglDeleteFramebuffersEXT(2, m_foveatedDepthFbos);
+	}
+	if (m_headerPbo)
+		mglDeleteBuffers(1, &m_headerPbo);
+	m_shader = m_reconstructShader = m_vao = m_packedFbo = m_headerPbo = 0;
+	m_attachedTexture = 0;
+	m_headerPboRows = 0;
+}
+
+bool interop::StereoTextureReceiver::receive() {
+	if (!m_receiver.receive())
+		return false;
+
+	const bool size_changed = m_receiver.m_width != m_packedWidth || m_receiver.m_height != m_packedHeight;
+	m_packedWidth = m_receiver.m_width;
+	m_packedHeight = m_receiver.m_height;
+	if (size_changed)
+		m_metadata.magic = 0; // read the new header before unpacking
+
+	this->readHeader();
+
+	if (m_metadata.magic != FrameMetadata::Magic || m_metadata.version < 1)
+		return false;
+
+	// foveated eye images are reconstructed at their full size
+	const StereoPackingFormat format = StereoPackingFormat::decode(m_metadata.format);
+	const bool foveated = m_metadata.version >= 3 && m_metadata.periphery_scale > 1;
+	const uint eye_width = foveated ? m_metadata.full_eye_width : m_metadata.eye_width;
+	const uint eye_height = foveated ? m_metadata.full_eye_height : m_metadata.eye_height;
+	const uint foveated_width = foveated ? m_metadata.eye_width : 0;
+	const uint foveated_height = foveated ? m_metadata.eye_height : 0;
+	if (m_metadata.format != m_packing.format.encode()
+		|| eye_width != m_packing.width || eye_height != m_packing.height
+		|| foveated_width != m_foveatedPacking.width || foveated_height != m_foveatedPacking.height) {
+		m_packing = StereoPacking::make(format, eye_width, eye_height);
+		m_foveatedPacking = foveated ? StereoPacking::make(format, foveated_width, foveated_height) : StereoPacking{};
+		this->makeTextures();
+	}
+
+	m_blocksUploaded = this->uploadBlocks();
+	this->unpack();
+	if (foveated)
+		this->reconstruct();
+	return true;
+}
+
+void interop::StereoTextureReceiver::readHeader() {
+	const uint width = m_packedWidth;
+	if (width == 0)
+		return;
+	// the struct, and the view table once the last header told how many rows it takes
+	const uint struct_rows = (FrameMetadata::words() + width - 1) / width;
+	const bool valid = m_metadata.magic == FrameMetadata::Magic;
+	const uint rows = (valid && m_metadata.header_rows > struct_rows && m_metadata.header_rows <= m_packedHeight)
+		? m_metadata.header_rows : struct_rows;
+	if (rows > m_packedHeight)
+		return;
+
+	const uint flip = m_receiver.m_flip_y;
+	const uint y = flip ? m_packedHeight - rows : 0;
+
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, m_packedFbo);
+	if (m_attachedTexture != m_receiver.m_texture_handle) {
+		mglFramebufferTexture2DEXT(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+			GL_TEXTURE_2D, m_receiver.m_texture_handle, 0);
+		m_attachedTexture = m_receiver.m_texture_handle;
+	}
+	glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
+
+	if (m_metadata.magic != FrameMetadata::Magic || m_syncHeader) {
+		// nothing to show without a header, wait for this one
+		m_headerPixels.resize(width * rows);
+		glReadPixels(0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, m_headerPixels.data());
+		this->parseHeader(m_headerPixels.data(), rows, flip);
+		const uint header_rows = m_metadata.header_rows;
+		if (m_metadata.magic == FrameMetadata::Magic && header_rows > rows && header_rows <= m_packedHeight) {
+			// the view table continues in the rows above
+			m_headerPixels.resize(width * header_rows);
+			glReadPixels(0, flip ? m_packedHeight - header_rows : 0, width, header_rows, GL_RGBA, GL_UNSIGNED_BYTE,
+				m_headerPixels.data());
+			this->parseHeader(m_headerPixels.data(), header_rows, flip);
+		}
+		m_headerPboRows = 0;
+	}
+	else {
+		// the read of the previous frame has finished by now, the current one is only started
+		mglBindBuffer(GL_PIXEL_PACK_BUFFER, m_headerPbo);
+		if (m_headerPboRows > 0) {
+			const ptrdiff_t size = width * m_headerPboRows * sizeof(uint);
+			const uint* pixels = static_cast<const uint*>(mglMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+			if (pixels)
+				this->parseHeader(pixels, m_headerPboRows, m_headerPboFlipped);
+			mglUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		mglBufferData(GL_PIXEL_PACK_BUFFER, width * rows * sizeof(uint), nullptr, GL_STREAM_READ);
+		glReadPixels(0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		mglBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		m_headerPboRows = rows;
+		m_headerPboFlipped = flip;
+	}
+
+	restorePreviousFbo(&fbo_backup);
+}
+
+bool interop::StereoTextureReceiver::hasEye(const uint eye) const {
+	// without a view table the header describes views 0 and 1
+	const uint view = m_firstView + eye;
+	return eye < 2 && view < ((m_metadata.version >= 2) ? m_metadata.view_count : 2);
+}
+
+interop::ViewMetadata interop::StereoTextureReceiver::eyeView(const uint eye) const {
+	const uint view = m_firstView + eye;
+	if (view < m_views.size())
+		return m_views[view];
+
+	ViewMetadata v;
+	if (eye < 2) {
+		v.color = m_metadata.color[eye];
+		v.depth = m_metadata.depth[eye];
+		v.view = m_metadata.view[eye];
+		v.projection = m_metadata.projection[eye];
+	}
+	return v;
+}
+
+void interop::StereoTextureReceiver::parseHeader(const uint* pixels, const uint rows, const bool flipped) {
+	FrameMetadata m;
+	std::vector<ViewMetadata> views;
+	if (readFrameMetadata(pixels, m_packedWidth, rows, flipped, m, &views)) {
+		m_metadata = m;
+		m_views = views;
+	}
+}
+
+void interop::StereoTextureReceiver::makeTextures() {
+	this->deleteTextures();
+
+	const auto makeTexture = [](uint& texture, const GLenum internal_format, const GLenum format,
+		const GLenum type, const uint width, const uint height) {
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			allocateTextureStorage(internal_format, format, type, width, height);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		};
+
+	const auto makeColorTarget = [&](uint& texture, const uint fbo, const StereoPacking& packing) {
+		makeTexture(texture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, packing.width, packing.height);
+		bindFramebuffer(GL_FRAMEBUFFER_EXT, fbo);
+		mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+			GL_TEXTURE_2D, texture, 0);
+		};
+	const auto makeDepthTarget = [&](uint& texture, const uint fbo, const StereoPacking& packing) {
+		makeTexture(texture, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT,
+			packing.depth_samples_x, packing.depth_samples_y);
+		bindFramebuffer(GL_FRAMEBUFFER_EXT, fbo);
+		mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
+			GL_TEXTURE_2D, texture, 0);
+		glDrawBuffer(GL_NONE);
+		};
+
+	const bool foveated = m_foveatedPacking.width > 0;
+	const StereoPacking& packed = foveated ? m_foveatedPacking : m_packing;
+	const ColorEncoding encoding = packed.format.color_encoding;
+	const bool block_color = encoding == ColorEncoding::BC1 || encoding == ColorEncoding::YCoCgDXT5;
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+	for (int eye = 0; eye < 2; eye++) {
+		if (m_blockUpload && block_color && packed.hasColor()) {
+			// whole blocks, the unpack pass only fetches the texels of the eye image
+			const GLenum internal_format = (encoding == ColorEncoding::BC1)
+				? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			makeTexture(m_blockTextures[eye], internal_format, GL_RGBA, GL_UNSIGNED_BYTE,
+				(packed.width + 3) / 4 * 4, (packed.height + 3) / 4 * 4);
+		}
+		if (m_packing.hasColor()) {
+			makeColorTarget(m_colorTextures[eye], m_colorFbos[eye], m_packing);
+			if (foveated)
+				makeColorTarget(m_foveatedColorTextures[eye], m_foveatedColorFbos[eye], m_foveatedPacking);
+		}
+		if (m_packing.hasDepth()) {
+			makeDepthTarget(m_depthTextures[eye], m_depthFbos[eye], m_packing);
+			if (foveated)
+				makeDepthTarget(m_foveatedDepthTextures[eye], m_foveatedDepthFbos[eye], m_foveatedPacking);
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	restorePreviousFbo(&fbo_backup);
+}
+
+void interop::StereoTextureReceiver::deleteTextures() {
+	for (int eye = 0; eye < 2; eye++) {
+		if (m_colorTextures[eye])
+			glDeleteTextures(1, &m_colorTextures[eye]);
+		if (m_depthTextures[eye])
+			glDeleteTextures(1, &m_depthTextures[eye]);
+		if (m_foveatedColorTextures[eye])
+			glDeleteTextures(1, &m_foveatedColorTextures[eye]);
+		if (m_foveatedDepthTextures[eye])
+			glDeleteTextures(1, &m_foveatedDepthTextures[eye]);
+		if (m_blockTextures[eye])
+			glDeleteTextures(1, &m_blockTextures[eye]);
+		m_colorTextures[eye] = m_depthTextures[eye] = 0;
+		m_foveatedColorTextures[eye] = m_foveatedDepthTextures[eye] = 0;
+		m_blockTextures[eye] = 0;
+	}
+	m_blocksUploaded = false;
+}
+
+// the blocks of the color regions straight from the network frame receive() uploaded, so the GL
+// decodes them when sampling. false if the frame was replaced meanwhile or its header does not fit
+// the textures, the unpack pass decodes the blocks from the packed image then
+bool interop::StereoTextureReceiver::uploadBlocks() {
+	if (!m_blockTextures[0])
+		return false;
+
+	auto& network = *static_cast<NetworkImageReceiver*>(m_receiver.m_receiver.get());
+	std::lock_guard<std::mutex> lock(network.mutex);
+	const NetworkFrame& frame = network.latest;
+	if (frame.sequence != m_receiver.m_frame_sequence || frame.width != m_packedWidth || frame.height != m_packedHeight)
+		return false;
+
+	// the header of this frame, m_metadata may still be the one of the frame before
+	const uint width = frame.width;
+	const uint* pixels = frame.pixels.data();
+	FrameMetadata m;
+	std::vector<ViewMetadata> views;
+	const uint struct_rows = (FrameMetadata::words() + width - 1) / width;
+	if (struct_rows > frame.height || !readFrameMetadata(pixels, width, struct_rows, false, m)
+		|| m.header_rows < struct_rows || m.header_rows > frame.height
+		|| !readFrameMetadata(pixels, width, m.header_rows, false, m, &views))
+		return false;
+
+	const StereoPacking& packed = (m_foveatedPacking.width > 0) ? m_foveatedPacking : m_packing;
+	if (m.format != m_packing.format.encode() || m.eye_width != packed.width || m.eye_height != packed.height)
+		return false;
+
+	const ColorEncoding encoding = packed.format.color_encoding;
+	const uint blocks_x = (packed.width + 3) / 4;
+	const uint blocks_y = (packed.height + 3) / 4;
+	const uint words = blocks_x * blocks_y * colorBlockPixels(encoding);
+	std::vector<uint> blocks[2];
+	for (uint eye = 0; eye < 2; eye++) {
+		if (!this->hasEye(eye))
+			continue;
+		const uint view = m_firstView + eye;
+		const Rect rect = (view < views.size()) ? views[view].color : m.color[eye];
+		if (rect.width == 0 || rect.x + rect.width > width
+			|| rect.y + (words + rect.width - 1) / rect.width > frame.height)
+			return false;
+
+		// the blocks fill the color region row by row
+		blocks[eye].resize(words);
+		for (uint w = 0; w < words; w += rect.width) {
+			const uint count = (words - w < rect.width) ? words - w : rect.width;
+			std::memcpy(&blocks[eye][w], &pixels[(rect.y + w / rect.width) * width + rect.x], count * sizeof(uint));
+		}
+	}
+
+	const GLenum internal_format = (encoding == ColorEncoding::BC1)
+		? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	for (uint eye = 0; eye < 2; eye++) {
+		if (blocks[eye].empty())
+			continue;
+		const GLint previous_active_texture = bindScratchTexture(m_blockTextures[eye]);
+		mglCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, blocks_x * 4, blocks_y * 4, internal_format,
+			static_cast<GLsizei>(words * sizeof(uint)), blocks[eye].data());
+		unbindScratchTexture(previous_active_texture);
+	}
+	return true;
+}
+
+void interop::StereoTextureReceiver::unpack() {
+	const GLint previous_active_texture = getActiveTexture();
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+
+	// depth is written with gl_FragDepth, which needs the depth test
+	const GlDepthState previous_depth = getDepthState();
+
+	mglUseProgram(m_shader);
+	mglBindVertexArray(m_vao);
+	setActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_receiver.m_texture_handle);
+	mglUniform1i(m_uniform_locations[0], 0);
+	mglUniform1i(m_uniform_locations[1], m_receiver.m_flip_y ? 1 : 0);
+
+	// foveated eye images are unpacked at their packed size, then reconstructed
+	const bool foveated = m_foveatedPacking.width > 0;
+	const StereoPacking& packing = foveated ? m_foveatedPacking : m_packing;
+	const uint* color_fbos = foveated ? m_foveatedColorFbos : m_colorFbos;
+	const uint* depth_fbos = foveated ? m_foveatedDepthFbos : m_depthFbos;
+	mglUniform1i(m_uniform_locations[4], static_cast<int>(packing.format.encode()));
+	mglUniform2i(m_uniform_locations[5], static_cast<int>(packing.width), static_cast<int>(packing.height));
+
+	for (uint eye = 0; eye < 2; eye++) {
+		if (!this->hasEye(eye))
+			continue;
+		mglUniform1i(m_uniform_locations[2], m_firstView + eye);
+
+		if (packing.hasColor()) {
+			// on the scratch unit, so only unit 0 of the application is taken
+			setActiveTexture(scratch_texture_unit);
+			glBindTexture(GL_TEXTURE_2D, m_blockTextures[eye]);
+			setActiveTexture(GL_TEXTURE0);
+			mglUniform1i(m_uniform_locations[7], scratch_texture_unit - GL_TEXTURE0);
+			mglUniform1i(m_uniform_locations[6], (m_blocksUploaded && m_blockTextures[eye]) ? 1 : 0);
+
+			bindFramebuffer(GL_FRAMEBUFFER_EXT, color_fbos[eye]);
+			glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT);
+			setViewport(0, 0, packing.width, packing.height);
+			setDepthState(no_depth_state);
+			mglUniform1i(m_uniform_locations[3], 0);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+
+		if (packing.hasDepth()) {
+			bindFramebuffer(GL_FRAMEBUFFER_EXT, depth_fbos[eye]);
+			setViewport(0, 0, packing.depth_samples_x, packing.depth_samples_y);
+			setDepthState(write_depth_state);
+			mglUniform1i(m_uniform_locations[3], 1);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+	}
+
+	setActiveTexture(scratch_texture_unit);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	setActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	mglBindVertexArray(0);
+	setDepthState(previous_depth);
+	restorePreviousFbo(&fbo_backup);
+	setActiveTexture(previous_active_texture);
+}
+
+void interop::StereoTextureReceiver::reconstruct() {
+	const GLint previous_active_texture = getActiveTexture();
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+
+	const GlDepthState previous_depth = getDepthState();
+
+	mglUseProgram(m_reconstructShader);
+	mglBindVertexArray(m_vao);
+	setActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_receiver.m_texture_handle);
+	mglUniform1i(m_reconstruct_uniform_locations[0], 0);
+	mglUniform1i(m_reconstruct_uniform_locations[1], m_receiver.m_flip_y ? 1 : 0);
+	mglUniform1i(m_reconstruct_uniform_locations[2], 1);
+	mglUniform1i(m_reconstruct_uniform_locations[3], 2);
+	mglUniform1i(m_reconstruct_uniform_locations[6], static_cast<int>(m_foveatedPacking.format.encode()));
+	mglUniform2i(m_reconstruct_uniform_locations[7], static_cast<int>(m_foveatedPacking.width), static_cast<int>(m_foveatedPacking.height));
+
+	for (int eye = 0; eye < 2; eye++) {
+		mglUniform1i(m_reconstruct_uniform_locations[4], eye);
+
+		if (m_packing.hasColor()) {
+			setActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, m_foveatedColorTextures[eye]);
+			bindFramebuffer(GL_FRAMEBUFFER_EXT, m_colorFbos[eye]);
+			glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT);
+			setViewport(0, 0, m_packing.width, m_packing.height);
+			setDepthState(no_depth_state);
+			mglUniform1i(m_reconstruct_uniform_locations[5], 0);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+
+		if (m_packing.hasDepth()) {
+			setActiveTexture(GL_TEXTURE2);
+			glBindTexture(GL_TEXTURE_2D, m_foveatedDepthTextures[eye]);
+			bindFramebuffer(GL_FRAMEBUFFER_EXT, m_depthFbos[eye]);
+			setViewport(0, 0, m_packing.depth_samples_x, m_packing.depth_samples_y);
+			setDepthState(write_depth_state);
+			mglUniform1i(m_reconstruct_uniform_locations[5], 1);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+	}
+
+	for (const GLint unit : { GL_TEXTURE2, GL_TEXTURE1, GL_TEXTURE0 }) {
+		setActiveTexture(unit);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	mglBindVertexArray(0);
+	setDepthState(previous_depth);
+	restorePreviousFbo(&fbo_backup);
+	setActiveTexture(previous_active_texture);
+}
+
+void interop::DepthPicker::init() {
+	loadGlExtensions();
+}
+
+void interop::DepthPicker::destroy() {
+	for (auto& pending : m_pending) {
+		mglDeleteSync(pending.fence);
+		m_freeBuffers.push_back(pending.buffer);
+	}
+	m_pending.clear();
+	if (!m_freeBuffers.empty())
+		mglDeleteBuffers(static_cast<GLsizei>(m_freeBuffers.size()), m_freeBuffers.data());
+	m_freeBuffers.clear();
+}
+
+// region of depth samples within radius pixels around (x, y), clamped to the image
+static void pickRegion(interop::DepthPicker::PendingPick& pending, const uint x, const uint y, const uint radius,
+	const uint reduction, const uint samples_x, const uint samples_y) {
+	const auto sample = [&](const int pixel, const uint samples) {
+		const int s = pixel / static_cast<int>(reduction);
+		return static_cast<uint>((s < 0) ? 0 : (s >= static_cast<int>(samples) ? samples - 1 : s));
+		};
+	const int r = static_cast<int>(radius);
+	const uint x0 = sample(static_cast<int>(x) - r, samples_x);
+	const uint y0 = sample(static_cast<int>(y) - r, samples_y);
+	const uint x1 = sample(static_cast<int>(x) + r, samples_x);
+	const uint y1 = sample(static_cast<int>(y) + r, samples_y);
+	pending.samples_x = samples_x;
+	pending.samples_y = samples_y;
+	pending.region_x = x0;
+	pending.region_y = y0;
+	pending.region_width = x1 - x0 + 1;
+	pending.region_height = y1 - y0 + 1;
+}
+
+uint interop::DepthPicker::request(const StereoTextureReceiver& receiver, const uint eye, const uint x, const uint y,
+	const uint radius) {
+	const StereoPacking& packing = receiver.m_packing;
+	if (eye > 1 || !packing.hasDepth() || !receiver.m_depthTextures[eye] || !receiver.m_attachedTexture)
+		return 0;
+
+	PendingPick pending;
+	pending.pick.id = m_nextId++;
+	pending.pick.eye = eye;
+	pending.pick.x = x;
+	pending.pick.y = y;
+	pickRegion(pending, x, y, radius, static_cast<uint>(packing.format.depth_resolution),
+		packing.depth_samples_x, packing.depth_samples_y);
+	const uint x0 = pending.region_x;
+	const uint y0 = pending.region_y;
+
+	// the header rows of the packed image belong to the unpacked depth until the next receive(),
+	// including the view table
+	pending.view = receiver.m_firstView + eye;
+	pending.header_width = receiver.m_packedWidth;
+	pending.header_rows = (FrameMetadata::words() + pending.header_width - 1) / pending.header_width;
+	if (receiver.m_metadata.header_rows > pending.header_rows && receiver.m_metadata.header_rows <= receiver.m_packedHeight)
+		pending.header_rows = receiver.m_metadata.header_rows;
+	pending.header_flipped = receiver.m_receiver.m_flip_y;
+	const uint header_bytes = pending.header_width * pending.header_rows * sizeof(uint);
+	const uint depth_bytes = pending.region_width * pending.region_height * sizeof(float);
+
+	if (m_freeBuffers.empty()) {
+		m_freeBuffers.push_back(0);
+		mglGenBuffers(1, &m_freeBuffers.back());
+	}
+	pending.buffer = m_freeBuffers.back();
+	m_freeBuffers.pop_back();
+
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+	mglBindBuffer(GL_PIXEL_PACK_BUFFER, pending.buffer);
+	mglBufferData(GL_PIXEL_PACK_BUFFER, header_bytes + depth_bytes, nullptr, GL_STREAM_READ);
+
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, receiver.m_packedFbo);
+	glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
+	const uint header_y = pending.header_flipped ? receiver.m_packedHeight - pending.header_rows : 0;
+	glReadPixels(0, header_y, pending.header_width, pending.header_rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, receiver.m_depthFbos[eye]);
+	glReadPixels(x0, y0, pending.region_width, pending.region_height, GL_DEPTH_COMPONENT, GL_FLOAT,
+		reinterpret_cast<void*>(static_cast<size_t>(header_bytes)));
+
+	mglBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	restorePreviousFbo(&fbo_backup);
+
+	pending.fence = mglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_pending.push_back(pending);
+	return pending.pick.id;
+}
+
+uint interop::DepthPicker::request(const glFramebuffer& fbo, const Rect& viewport, const uint eye,
+	const uint x, const uint y, const mat4& view, const mat4& projection, const uint radius, const uint frame_sequence) {
+	if (!fbo.m_glFbo || !fbo.m_glTextureDepth || viewport.width == 0 || viewport.height == 0)
+		return 0;
+
+	PendingPick pending;
+	pending.pick.id = m_nextId++;
+	pending.pick.eye = eye;
+	pending.pick.x = x;
+	pending.pick.y = y;
+	pending.pick.frame_sequence = frame_sequence;
+	pickRegion(pending, x, y, radius, 1, viewport.width, viewport.height);
+	// no header rows, the camera is given
+	pending.view_matrix = view;
+	pending.projection = projection;
+	const uint depth_bytes = pending.region_width * pending.region_height * sizeof(float);
+
+	if (m_freeBuffers.empty()) {
+		m_freeBuffers.push_back(0);
+		mglGenBuffers(1, &m_freeBuffers.back());
+	}
+	pending.buffer = m_freeBuffers.back();
+	m_freeBuffers.pop_back();
+
+	glFramebuffer fbo_backup;
+	savePreviousFbo(&fbo_backup);
+	mglBindBuffer(GL_PIXEL_PACK_BUFFER, pending.buffer);
+	mglBufferData(GL_PIXEL_PACK_BUFFER, depth_bytes, nullptr, GL_STREAM_READ);
+
+	bindFramebuffer(GL_READ_FRAMEBUFFER_EXT, fbo.m_glFbo);
+	glReadPixels(viewport.x + pending.region_x, viewport.y + pending.region_y, pending.region_width, pending.region_height,
+		GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+	mglBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	restorePreviousFbo(&fbo_backup);
+
+	pending.fence = mglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_pending.push_back(pending);
+	return pending.pick.id;
+}
+
+std::vector<interop::DepthPicker::Pick> interop::DepthPicker::poll() {
+	std::vector<Pick> picks;
+
+	// readbacks finish in request order
+	size_t done = 0;
+	for (; done < m_pending.size(); done++) {
+		PendingPick& pending = m_pending[done];
+		const GLenum status = mglClientWaitSync(pending.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		mglDeleteSync(pending.fence);
+
+		const uint header_pixels = pending.header_width * pending.header_rows;
+		const uint region_samples = pending.region_width * pending.region_height;
+		mglBindBuffer(GL_PIXEL_PACK_BUFFER, pending.buffer);
+		const uint* data = static_cast<const uint*>(mglMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+			(header_pixels + region_samples) * sizeof(uint), GL_MAP_READ_BIT));
+
+		// cameras from the header rows, or given to request() without them
+		Pick& pick = pending.pick;
+		FrameMetadata metadata;
+		std::vector<ViewMetadata> views;
+		const bool from_header = pending.header_rows > 0;
+		if (data && (!from_header
+			|| readFrameMetadata(data, pending.header_width, pending.header_rows, pending.header_flipped, metadata, &views))) {
+			const float* depth = reinterpret_cast<const float*>(data + header_pixels);
+			uint closest = 0;
+			for (uint i = 1; i < region_samples; i++)
+				if (depth[i] < depth[closest])
+					closest = i;
+
+			const uint eye = pick.eye;
+			const float sample_x = pending.region_x + closest % pending.region_width + 0.5f;
+			const float sample_y = pending.region_y + closest / pending.region_width + 0.5f;
+			pick.depth = depth[closest];
+			pick.hit = pick.depth < 1.0f;
+			const bool table = pending.view < views.size();
+			const mat4& view = !from_header ? pending.view_matrix : (table ? views[pending.view].view : metadata.view[eye]);
+			const mat4& projection = !from_header ? pending.projection
+				: (table ? views[pending.view].projection : metadata.projection[eye]);
+			pick.world = unproject(sample_x / pending.samples_x, sample_y / pending.samples_y, pick.depth, view, projection);
+			if (from_header)
+				pick.frame_sequence = metadata.frame_sequence;
+		}
+		if (data)
+			mglUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		mglBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		m_freeBuffers.push_back(pending.buffer);
+		picks.push_back(pick);
+	}
+	m_pending.erase(m_pending.begin(), m_pending.begin() + done);
+
+	return picks;
+}
+
+static const float dynamic_resolution_step = 1.0f / 32.0f; // scales are multiples of it
+static const uint dynamic_resolution_settle_frames = 8; // measured at a scale before it may change again
+static const float dynamic_resolution_smoothing = 0.1f;
+static const float dynamic_resolution_headroom = 0.9f; // of the target frame time a new scale aims for
+static const float dynamic_resolution_grow_below = 0.75f; // of the target frame time, to scale up again
+
+void interop::DynamicResolution::init(const float target_ms, const float min_scale, const float max_scale) {
+	loadGlExtensions();
+	m_targetMs = target_ms;
+	m_minScale = (min_scale > dynamic_resolution_step) ? min_scale : dynamic_resolution_step;
+	m_maxScale = (max_scale > m_minScale) ? max_scale : m_minScale;
+	m_scale = m_maxScale;
+	m_frameMs = m_gpuMs = -1.0f;
+	m_framesAtScale = 0;
+	m_timerQueryIndex = 0;
+	if (!m_timerQueries[0])
+		mglGenQueries(2 * timer_queries, m_timerQueries);
+}
+
+void interop::DynamicResolution::destroy() {
+	if (m_timerQueries[0])
+		mglDeleteQueries(2 * timer_queries, m_timerQueries);
+	for (uint& query : m_timerQueries)
+		query = 0;
+}
+
+void interop::DynamicResolution::beginFrame() {
+	// timestamps instead of an elapsed time query, which could not enclose the timer of the packer.
+	// each pair is read again timer_queries frames later, a result not available yet is skipped
+	const uint slot = m_timerQueryIndex % timer_queries;
+	if (m_timerQueryIndex >= timer_queries) {
+		GLint available = 0;
+		mglGetQueryObjectiv(m_timerQueries[2 * slot + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		// frames rendered before the scale changed do not count
+		if (available && m_queryScales[slot] == m_scale) {
+			unsigned long long start_ns = 0, end_ns = 0;
+			mglGetQueryObjectui64v(m_timerQueries[2 * slot], GL_QUERY_RESULT, &start_ns);
+			mglGetQueryObjectui64v(m_timerQueries[2 * slot + 1], GL_QUERY_RESULT, &end_ns);
+			m_gpuMs = static_cast<float>((end_ns - start_ns) / 1000000.0);
+		}
+	}
+	m_queryScales[slot] = m_scale;
+	mglQueryCounter(m_timerQueries[2 * slot], GL_TIMESTAMP);
+	m_frameStartNs = nowNs();
+}
+
+void interop::DynamicResolution::endFrame() {
+	mglQueryCounter(m_timerQueries[2 * (m_timerQueryIndex % timer_queries) + 1], GL_TIMESTAMP);
+	m_timerQueryIndex++;
+	m_cpuMs = static_cast<float>((nowNs() - m_frameStartNs) / 1000000.0);
+
+	// wait for the GPU time of the current scale, it lags a few frames behind
+	if (m_gpuMs >= 0.0f)
+		this->update((m_gpuMs > m_cpuMs) ? m_gpuMs : m_cpuMs);
+}
+
+float interop::DynamicResolution::getScale() const {
+	return m_scale;
+}
 
-	return true;
+uint interop::DynamicResolution::scaled(const uint size) const {
+	const uint s = static_cast<uint>(size * m_scale + 0.5f);
+	return (s < 1) ? 1 : s;
 }
-#undef m_spout
 
-interop::StereoTextureSender::StereoTextureSender() {}
-interop::StereoTextureSender::~StereoTextureSender() {}
+void interop::DynamicResolution::update(const float frame_ms) {
+	if (m_targetMs <= 0.0f)
+		return;
 
-void interop::StereoTextureSender::init(std::string name, uint width, uint height) {
+	m_frameMs = (m_frameMs < 0.0f) ? frame_ms : m_frameMs + dynamic_resolution_smoothing * (frame_ms - m_frameMs);
+	if (++m_framesAtScale < dynamic_resolution_settle_frames)
+		return;
 
-	m_width = width;
-	m_height = height;
+	// hold the scale between the two thresholds, so it does not oscillate around the target
+	const bool over_budget = m_frameMs > m_targetMs;
+	const bool room_to_grow = m_frameMs < m_targetMs * dynamic_resolution_grow_below && m_scale < m_maxScale;
+	if (!over_budget && !room_to_grow)
+		return;
 
-	m_hugeFbo.init();
-	m_hugeTextureSender.init(interop::ImageType::SingleStereo, name, width, height);
-	this->initGLresources();
+	// the frame time follows the pixel count, the square of the scale
+	float scale = m_scale * std::sqrt(m_targetMs * dynamic_resolution_headroom / m_frameMs);
+	scale = std::floor(scale / dynamic_resolution_step) * dynamic_resolution_step;
+	scale = (scale < m_minScale) ? m_minScale : (scale > m_maxScale ? m_maxScale : scale);
+	if (scale == m_scale)
+		return;
 
-	this->makeHugeTexture(m_width, m_height);
+	m_scale = scale;
+	m_frameMs = m_gpuMs = -1.0f;
+	m_framesAtScale = 0;
 }
 
-void interop::StereoTextureSender::destroy() {
-	m_hugeFbo.destroy();
-	m_hugeTextureSender.destroy();
-	this->destroyGLresources();
+void interop::FrameCredits::init(const uint max_in_flight, const uint timeout_ms) {
+	*this = FrameCredits{};
+	m_maxInFlight = max_in_flight;
+	m_timeoutNs = timeout_ms * 1000000ull;
 }
 
-void interop::StereoTextureSender::makeHugeTexture(const uint originalWidth,
-	const uint originalHeight) {
-	m_hugeWidth = originalWidth * 2;
-	m_hugeHeight = originalHeight * 2;
-
-	m_hugeFbo.resizeTexture(m_hugeWidth, m_hugeHeight);
-	m_hugeTextureSender.resize(m_hugeWidth,
-		m_hugeHeight); // resizes sender texture
+void interop::FrameCredits::sent(const uint frame_sequence) {
+	m_sent = frame_sequence;
 }
 
-void interop::StereoTextureSender::send(glFramebuffer& fb_left,
-	glFramebuffer& fb_right,
-	const uint width,
-	const uint height,
-	const uint meta_data, const uint meta_data_2) {
-	this->send(fb_left.m_glTextureRGBA8, fb_right.m_glTextureRGBA8,
-		fb_left.m_glTextureDepth, fb_right.m_glTextureDepth,
-		width, height, meta_data, meta_data_2);
+void interop::FrameCredits::acknowledge(const uint frame_sequence, const uint dropped_frames) {
+	m_droppedFrames = dropped_frames;
+	// the latest acknowledgement is received again until the display sends a newer one. an older one
+	// would count frames the display already showed as in flight again
+	if (m_acknowledgedNs && frame_sequence <= m_acknowledged)
+		return;
+
+	m_acknowledged = frame_sequence;
+	m_acknowledgedNs = nowNs();
 }
 
-void interop::StereoTextureSender::send(
-	const uint color_left, const uint color_right, const uint depth_left,
-	const uint depth_right, const uint width, const uint height,
-	const uint meta_data, const uint meta_data_2) {
-	if (m_width != width || m_height != height)
-		this->makeHugeTexture(width, height);
+uint interop::FrameCredits::inFlight() const {
+	// a restarted sender counts from 0 again, below the last acknowledged frame
+	return (m_sent > m_acknowledged) ? m_sent - m_acknowledged : 0;
+}
 
-	this->blitTextures(color_left, color_right, depth_left, depth_right, width,
-		height, meta_data, meta_data_2);
+bool interop::FrameCredits::canSend() const {
+	if (m_maxInFlight == 0 || m_acknowledgedNs == 0 || this->inFlight() < m_maxInFlight)
+		return true;
 
-	m_hugeTextureSender.send(m_hugeFbo);
+	// the display stopped acknowledging, it may be gone
+	return nowNs() - m_acknowledgedNs > m_timeoutNs;
 }
 
-void interop::StereoTextureSender::initGLresources() {
+void interop::ImagePacker::init(const StereoLayout layout) {
 	const char* vertex_shader_source =
 		R"(
 	#version 400
@@ -590,147 +3828,631 @@ void interop::StereoTextureSender::initGLresources() {
 	}
 )";
 
-	const char* fragment_shader_source =
+	// the shaders are specialized for the layout, so layouts without color or depth do not sample those textures
+	m_layout = layout;
+	const std::string layout_defines =
+		"#define LAYOUT_COLOR_DEPTH " + std::to_string(static_cast<int>(StereoLayout::ColorDepth)) + "\n"
+		"#define LAYOUT_COLOR_SIDE_BY_SIDE " + std::to_string(static_cast<int>(StereoLayout::ColorSideBySide)) + "\n"
+		"#define LAYOUT_COLOR_TOP_BOTTOM " + std::to_string(static_cast<int>(StereoLayout::ColorTopBottom)) + "\n"
+		"#define LAYOUT_DEPTH_ONLY " + std::to_string(static_cast<int>(StereoLayout::DepthOnly)) + "\n"
+		"#define LAYOUT " + std::to_string(static_cast<int>(m_layout)) + "\n";
+	const std::string fragment_shader_header = "#version 400\n" + layout_defines;
+	const std::string compute_shader_header = "#version 430\n" + layout_defines;
+
+	// inputs and depth encoding, shared by the fragment and compute packing
+	const char* packing_shader_common =
 		R"(
-	#version 400
-
-	in vec4 gl_FragCoord;
+	#define HAS_COLOR (LAYOUT != LAYOUT_DEPTH_ONLY)
+	#define HAS_DEPTH (LAYOUT == LAYOUT_COLOR_DEPTH || LAYOUT == LAYOUT_DEPTH_ONLY)
 
 	uniform sampler2D left_color;
 	uniform sampler2D right_color;
 	uniform sampler2D left_depth;
 	uniform sampler2D right_depth;
 	uniform ivec2 texture_size;
-	uniform int meta_data;
-	uniform int meta_data_2;
+	uniform vec2 depth_range; // near, far
+	uniform int depth_encoding; // DepthEncoding: 0 = float32, 1 = linear24, 2 = linear16
+	uniform int depth_resolution; // DepthResolution: 1, 2 or 4
+	uniform int color_encoding; // ColorEncoding: 0 = rgba8, 1 = bc1, 2 = ycocg dxt5, 3 = yuv420
+	uniform ivec4 color_rect[2]; // x, y, width, height of left and right color in the packed image
+	uniform ivec4 depth_rect[2];
+	uniform ivec2 depth_origin[2]; // lower left of left and right view in their depth textures
+
+	vec4 uintToRGBA8(uint v) {
+		return vec4(
+			float((v >> 0 ) & 0x000000FFu),           // r: 0..7
+			float((v >> 8 ) & 0x000000FFu),           // g: 8..15
+			float((v >> 16) & 0x000000FFu),           // b: 16..23
+			float((v >> 24) & 0x000000FFu) ) / 255.0; // a: 24..31
+	}
 
-	out vec4 FragColor;
+#if HAS_COLOR
+	// pixels at the image border repeat
+	vec3 fetchColor(bool side, ivec2 coord) {
+		coord = min(coord, texture_size - ivec2(1));
+		return (side)
+			? texelFetch(left_color, coord, 0).rgb
+			: texelFetch(right_color, coord, 0).rgb;
+	}
 
-	void main()
-	{
-		vec4 result = vec4(0.0f);
-		ivec2 screen_coords = ivec2(gl_FragCoord.xy);
+	// the 4x4 pixels of a block
+	void fetchBlock(bool side, ivec2 block, out vec3 pixels[16]) {
+		for (int i = 0; i < 16; i++)
+			pixels[i] = fetchColor(side, block * 4 + ivec2(i % 4, i / 4));
+	}
 
-		if(screen_coords == ivec2(0,0)) {
-			FragColor = unpackUnorm4x8(uint(meta_data));
-			return;
+	// byte b of the YUV420 planes, full range BT.601
+	float yuvByte(bool side, int b) {
+		int luma_bytes = texture_size.x * texture_size.y;
+		if (b < luma_bytes)
+			return dot(fetchColor(side, ivec2(b % texture_size.x, b / texture_size.x)), vec3(0.299, 0.587, 0.114));
+
+		ivec2 chroma_size = (texture_size + ivec2(1)) / 2;
+		int chroma_bytes = chroma_size.x * chroma_size.y;
+		b -= luma_bytes;
+		if (b >= 2 * chroma_bytes)
+			return 0.0;
+
+		// U and V of the average of 2x2 pixels
+		int c = b % chroma_bytes;
+		ivec2 coord = 2 * ivec2(c % chroma_size.x, c / chroma_size.x);
+		vec3 rgb = 0.25 * (fetchColor(side, coord) + fetchColor(side, coord + ivec2(1, 0))
+			+ fetchColor(side, coord + ivec2(0, 1)) + fetchColor(side, coord + ivec2(1, 1)));
+		float luma = dot(rgb, vec3(0.299, 0.587, 0.114));
+		return (b < chroma_bytes)
+			? (rgb.b - luma) * 0.564 + 0.5
+			: (rgb.r - luma) * 0.713 + 0.5;
+	}
+
+	uint toRGB565(vec3 c) {
+		uvec3 q = uvec3(round(clamp(c, 0.0, 1.0) * vec3(31.0, 63.0, 31.0)));
+		return (q.r << 11) | (q.g << 5) | q.b;
+	}
+
+	vec3 fromRGB565(uint c) {
+		return vec3((c >> 11) & 0x1Fu, (c >> 5) & 0x3Fu, c & 0x1Fu) / vec3(31.0, 63.0, 31.0);
+	}
+
+	// BC1 color part: end points from the slightly inset bounding box of the block, every pixel
+	// takes the closest of the 4 colors between them. x = end points, y = 2 bit indices
+	uvec2 encodeColorBlock(vec3 pixels[16]) {
+		vec3 lo = pixels[0];
+		vec3 hi = pixels[0];
+		for (int i = 1; i < 16; i++) {
+			lo = min(lo, pixels[i]);
+			hi = max(hi, pixels[i]);
 		}
-		if(screen_coords == ivec2(1,0)) {
-			FragColor = unpackUnorm4x8(uint(meta_data_2));
-			return;
+		vec3 inset = (hi - lo) / 16.0;
+		uint c0 = toRGB565(hi - inset); // c0 >= c1 as every channel of hi is >= lo
+		uint c1 = toRGB565(lo + inset);
+
+		uint indices = 0u;
+		if (c0 != c1) {
+			vec3 e0 = fromRGB565(c0);
+			vec3 e1 = fromRGB565(c1);
+			vec3 axis = e0 - e1;
+			float length2 = dot(axis, axis);
+			for (int i = 0; i < 16; i++) {
+				int level = int(round(clamp(dot(pixels[i] - e1, axis) / length2, 0.0, 1.0) * 3.0));
+				uint index = (level == 3) ? 0u : (level == 0) ? 1u : uint(4 - level); // c0, c1, 2/3 c0, 1/3 c0
+				indices |= index << (2 * i);
+			}
+		}
+		return uvec2(c0 | (c1 << 16), indices);
+	}
+
+	// DXT5 alpha part: 8 bit end points, every value takes the closest of the 8 values between them.
+	// 3 bit indices follow the end points, x = end points and indices 0..15, y = indices 16..47
+	uvec2 encodeAlphaBlock(float values[16]) {
+		float lo = values[0];
+		float hi = values[0];
+		for (int i = 1; i < 16; i++) {
+			lo = min(lo, values[i]);
+			hi = max(hi, values[i]);
+		}
+		uint a0 = uint(round(clamp(hi, 0.0, 1.0) * 255.0));
+		uint a1 = uint(round(clamp(lo, 0.0, 1.0) * 255.0));
+
+		uint low = 0u;
+		uint high = 0u;
+		if (a0 != a1) {
+			for (int i = 0; i < 16; i++) {
+				int level = int(round(clamp((values[i] * 255.0 - float(a1)) / float(a0 - a1), 0.0, 1.0) * 7.0));
+				uint index = (level == 7) ? 0u : (level == 0) ? 1u : uint(8 - level);
+				int bit = 3 * i;
+				if (bit < 32)
+					low |= index << bit;
+				if (bit > 29)
+					high |= (bit >= 32) ? index << (bit - 32) : index >> (32 - bit);
+			}
+		}
+		return uvec2(a0 | (a1 << 8) | (low << 16), (low >> 16) | (high << 16));
+	}
+
+	// the 2 BC1 or 4 YCoCg DXT5 words of a block, blocks are row major
+	uvec4 encodeBlock(bool side, int block) {
+		ivec2 blocks = (texture_size + ivec2(3)) / 4;
+		vec3 pixels[16];
+		fetchBlock(side, ivec2(block % blocks.x, block / blocks.x), pixels);
+		if (color_encoding == 1)
+			return uvec4(encodeColorBlock(pixels), 0u, 0u);
+
+		// YCoCg, Co and Cg are scaled up for blocks of low chroma, the blue of the end points holds scale - 1
+		float luma[16];
+		float chroma = 0.0;
+		for (int p = 0; p < 16; p++) {
+			vec3 c = pixels[p];
+			luma[p] = dot(c, vec3(0.25, 0.5, 0.25));
+			pixels[p] = vec3(0.5 * (c.r - c.b), dot(c, vec3(-0.25, 0.5, -0.25)), 0.0);
+			chroma = max(chroma, max(abs(pixels[p].x), abs(pixels[p].y)));
+		}
+		float scale = (chroma < 32.0 / 255.0) ? 4.0 : (chroma < 64.0 / 255.0) ? 2.0 : 1.0;
+		for (int p = 0; p < 16; p++)
+			pixels[p] = vec3(pixels[p].xy * scale + 0.5, (scale - 1.0) / 31.0);
+		return uvec4(encodeAlphaBlock(luma), encodeColorBlock(pixels));
+	}
+
+	// blocks are stored row major, filling the color region pixel by pixel
+	vec4 colorPixel(bool side, ivec2 region_coord) {
+		if (color_encoding == 0)
+			return (side)
+				? texelFetch(left_color, region_coord, 0)
+				: texelFetch(right_color, region_coord, 0);
+
+		if (color_encoding == 3) {
+			int b = 4 * (region_coord.y * texture_size.x + region_coord.x);
+			return vec4(yuvByte(side, b), yuvByte(side, b + 1), yuvByte(side, b + 2), yuvByte(side, b + 3));
 		}
 
-		bool side = bool(screen_coords.x < texture_size.x); // true => left side, false => right side
-		bool color_or_depth = bool(screen_coords.y < texture_size.y); // true => color, false => depth
-		ivec2 lookup_coord = ivec2(mod(gl_FragCoord.xy, texture_size.xy));
+		int block_pixels = (color_encoding == 1) ? 2 : 4;
+		ivec2 blocks = (texture_size + ivec2(3)) / 4;
+		int i = region_coord.y * texture_size.x + region_coord.x;
+		int block = i / block_pixels;
+		if (block >= blocks.x * blocks.y)
+			return vec4(0.0);
 
-		if(color_or_depth) { // color
-			result = (side) 
-                ? texelFetch(left_color, lookup_coord, 0).rgba
-                : texelFetch(right_color, lookup_coord, 0).rgba;
-		} else { // depth
-			float depth = (side) 
-                ? texelFetch(left_depth, lookup_coord, 0).r
-                : texelFetch(right_depth, lookup_coord, 0).r;
+		// a fragment only writes its own pixel, so it encodes the whole block and keeps its part.
+		// the compute pass encodes every block once and stores all of its pixels
+		return uintToRGBA8(encodeBlock(side, block)[i % block_pixels]);
+	}
+#endif
+
+#if HAS_DEPTH
+	// window depth to linear depth, normalized to [near, far]
+	float linearDepth(float depth) {
+		float n = depth_range.x;
+		float f = depth_range.y;
+		float z_ndc = depth * 2.0 - 1.0;
+		float z_eye = (2.0 * n * f) / (f + n - z_ndc * (f - n));
+		return clamp((z_eye - n) / (f - n), 0.0, 1.0);
+	}
 
-			uint deph_uint = floatBitsToUint(depth); // version 330
-			//vec4 depth_rgba8 = unpackUnorm4x8(deph_uint); // version 400
-			vec4 depth_rgba8 = vec4(
-				float((deph_uint >> 0 ) & 0x000000FF),           // r: 0..7
-				float((deph_uint >> 8 ) & 0x000000FF),           // g: 8..15
-				float((deph_uint >> 16) & 0x000000FF),           // b: 16..23
-				float((deph_uint >> 24) & 0x000000FF) ) / 255.0; // a: 24..31
+	// closest depth of the full resolution pixels covered by one depth sample
+	float fetchDepth(bool side, ivec2 sample_coord) {
+		float depth = uintBitsToFloat(0x7F7FFFFFu); // max float
+		for (int y = 0; y < depth_resolution; y++)
+		for (int x = 0; x < depth_resolution; x++) {
+			ivec2 coord = min(sample_coord * depth_resolution + ivec2(x, y), texture_size - ivec2(1))
+				+ depth_origin[side ? 0 : 1];
+			float d = (side)
+				? texelFetch(left_depth, coord, 0).r
+				: texelFetch(right_depth, coord, 0).r;
+			depth = min(depth, d);
+		}
+		return depth;
+	}
 
-			result = depth_rgba8;
+	// depth samples are stored row major as a bit stream filling the depth region pixel by pixel,
+	// 32, 24 or 16 bits per sample. a 24 bit sample may continue in the next pixel
+	vec4 depthPixel(bool side, ivec2 region_coord) {
+		ivec2 samples = (texture_size + ivec2(depth_resolution - 1)) / depth_resolution;
+		int sample_bits = (depth_encoding == 0) ? 32 : (depth_encoding == 1) ? 24 : 16;
+		int first_bit = (region_coord.y * texture_size.x + region_coord.x) * 32;
+		int first_sample = first_bit / sample_bits;
+		int last_sample = (first_bit + 31) / sample_bits;
+
+		uint bits = 0u;
+		for (int i = first_sample; i <= last_sample; i++) {
+			if (i >= samples.x * samples.y)
+				break;
+
+			float depth = fetchDepth(side, ivec2(i % samples.x, i / samples.x));
+
+			uint value;
+			if (depth_encoding == 0)
+				value = floatBitsToUint(depth); // version 330
+			else if (depth_encoding == 1)
+				value = uint(round(linearDepth(depth) * 16777215.0));
+			else
+				value = uint(round(linearDepth(depth) * 65535.0));
+
+			int offset = i * sample_bits - first_bit;
+			bits |= (offset >= 0) ? (value << offset) : (value >> -offset);
 		}
-		
 
-		FragColor = result;
-		//FragColor = vec4(mod(gl_FragCoord.xy, texture_size.xy)/(texture_size.xy), 0.0f, 1.0f);
+		return uintToRGBA8(bits);
 	}
+#endif
 )";
 
-	const uint vertex_shader = mglCreateShader(GL_VERTEX_SHADER);
-	mglShaderSource(vertex_shader, 1, &vertex_shader_source, NULL);
-	mglCompileShader(vertex_shader);
-	const uint fragment_shader = mglCreateShader(GL_FRAGMENT_SHADER);
-	mglShaderSource(fragment_shader, 1, &fragment_shader_source, NULL);
-	mglCompileShader(fragment_shader);
+	const char* fragment_shader_body =
+		R"(
+	in vec4 gl_FragCoord;
 
-	m_shader = mglCreateProgram();
-	mglAttachShader(m_shader, vertex_shader);
-	mglAttachShader(m_shader, fragment_shader);
-	mglLinkProgram(m_shader);
+	out vec4 FragColor;
 
-	int success = 0;
-	mglGetProgramiv(m_shader, GL_LINK_STATUS, &success);
-	if (!success) {
-		std::string infoLog;
-		infoLog.resize(512);
-		mglGetProgramInfoLog(m_shader, 512, NULL,
-			const_cast<char*>(infoLog.c_str()));
-		std::cout << infoLog << std::endl;
+	bool inRect(ivec2 coord, ivec4 rect) {
+		return all(greaterThanEqual(coord, rect.xy)) && all(lessThan(coord, rect.xy + rect.zw));
 	}
 
-	mglDeleteShader(vertex_shader);
-	mglDeleteShader(fragment_shader);
+	void main()
+	{
+		ivec2 screen_coords = ivec2(gl_FragCoord.xy);
+
+		// the viewport covers more than the regions if they are not adjacent. other pixels belong to
+		// other passes or the header rows, which are written by the sender afterwards
+#if HAS_COLOR
+		if (inRect(screen_coords, color_rect[0]))
+			FragColor = colorPixel(true, screen_coords - color_rect[0].xy);
+		else if (inRect(screen_coords, color_rect[1]))
+			FragColor = colorPixel(false, screen_coords - color_rect[1].xy);
+		else
+#endif
+#if HAS_DEPTH
+		if (inRect(screen_coords, depth_rect[0]))
+			FragColor = depthPixel(true, screen_coords - depth_rect[0].xy);
+		else if (inRect(screen_coords, depth_rect[1]))
+			FragColor = depthPixel(false, screen_coords - depth_rect[1].xy);
+		else
+#endif
+			discard;
+	}
+)";
+
+	const char* compute_shader_body =
+		R"(
+	layout(local_size_x = 8, local_size_y = 8) in;
+	layout(binding = 0, rgba8) writeonly uniform image2D packed_image;
+
+	uniform int first_region; // 0, 1 = first and second color, 2, 3 = first and second depth
+
+	void main()
+	{
+		// each z slice of workgroups packs one region, so all invocations of a workgroup take the same path
+		int region = first_region + int(gl_WorkGroupID.z);
+		ivec4 rect = (region < 2) ? color_rect[region] : depth_rect[region - 2];
+		ivec2 region_coord = ivec2(gl_GlobalInvocationID.xy);
+		if (any(greaterThanEqual(region_coord, rect.zw)))
+			return;
+
+#if HAS_COLOR
+		// block encoded color: every invocation encodes one block and stores its 2 or 4 pixels
+		if (region < 2 && (color_encoding == 1 || color_encoding == 2)) {
+			int block_pixels = (color_encoding == 1) ? 2 : 4;
+			ivec2 blocks = (texture_size + ivec2(3)) / 4;
+			int block = region_coord.y * rect.z + region_coord.x;
+			if (block >= blocks.x * blocks.y)
+				return;
+
+			uvec4 words = encodeBlock(region == 0, block);
+			for (int p = 0; p < block_pixels; p++) {
+				int i = block * block_pixels + p;
+				imageStore(packed_image, rect.xy + ivec2(i % texture_size.x, i / texture_size.x), uintToRGBA8(words[p]));
+			}
+			return;
+		}
+#endif
+
+		vec4 result = vec4(0.0f);
+#if HAS_COLOR
+		if (region < 2)
+			result = colorPixel(region == 0, region_coord);
+#endif
+#if HAS_DEPTH
+		if (region >= 2)
+			result = depthPixel(region == 2, region_coord);
+#endif
+
+		imageStore(packed_image, rect.xy + region_coord, result);
+	}
+)";
 
-	m_uniform_locations[0] = mglGetUniformLocation(m_shader, "texture_size");
-	m_uniform_locations[1] = mglGetUniformLocation(m_shader, "left_color");
-	m_uniform_locations[2] = mglGetUniformLocation(m_shader, "left_depth");
-	m_uniform_locations[3] = mglGetUniformLocation(m_shader, "right_color");
-	m_uniform_locations[4] = mglGetUniformLocation(m_shader, "right_depth");
-	m_uniform_locations[5] = mglGetUniformLocation(m_shader, "meta_data");
-	m_uniform_locations[6] = mglGetUniformLocation(m_shader, "meta_data_2");
+	const uint vertex_shader = compileShader(GL_VERTEX_SHADER, { vertex_shader_source });
+	const uint fragment_shader = compileShader(GL_FRAGMENT_SHADER, { fragment_shader_header.c_str(), packing_shader_common, fragment_shader_body });
+	m_shader = linkProgram(vertex_shader, fragment_shader);
+
+	const auto getPackingUniforms = [](const uint program, uint* locations) {
+		locations[0] = mglGetUniformLocation(program, "texture_size");
+		locations[1] = mglGetUniformLocation(program, "left_color");
+		locations[2] = mglGetUniformLocation(program, "left_depth");
+		locations[3] = mglGetUniformLocation(program, "right_color");
+		locations[4] = mglGetUniformLocation(program, "right_depth");
+		locations[5] = mglGetUniformLocation(program, "depth_range");
+		locations[6] = mglGetUniformLocation(program, "depth_encoding");
+		locations[7] = mglGetUniformLocation(program, "depth_resolution");
+		locations[8] = mglGetUniformLocation(program, "color_rect[0]");
+		locations[9] = mglGetUniformLocation(program, "color_rect[1]");
+		locations[10] = mglGetUniformLocation(program, "depth_rect[0]");
+		locations[11] = mglGetUniformLocation(program, "depth_rect[1]");
+		locations[12] = mglGetUniformLocation(program, "depth_origin[0]");
+		locations[13] = mglGetUniformLocation(program, "depth_origin[1]");
+		locations[14] = mglGetUniformLocation(program, "color_encoding");
+		};
+	getPackingUniforms(m_shader, m_uniform_locations);
+
+	// compute shaders and image load/store are core in GL 4.3
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	const bool has_gl43 = (major > 4 || (major == 4 && minor >= 3));
+	const bool has_compute = has_gl43 && mglDispatchCompute && mglBindImageTexture && mglMemoryBarrier;
+	m_copyImageAvailable = has_gl43 && mglCopyImageSubData;
+	m_copyableTextures.clear();
+	m_computeShader = 0;
+	if (has_compute) {
+		const uint compute_shader = compileShader(GL_COMPUTE_SHADER, { compute_shader_header.c_str(), packing_shader_common, compute_shader_body });
+		m_computeShader = linkProgram(compute_shader, 0);
+		if (m_computeShader) {
+			getPackingUniforms(m_computeShader, m_compute_uniform_locations);
+			m_compute_uniform_locations[15] = mglGetUniformLocation(m_computeShader, "first_region");
+		}
+	}
+	this->selectPath();
 
 	mglGenVertexArrays(1, &m_vao);
+	mglGenQueries(timer_queries, m_timerQueries);
+	m_timerQueryIndex = 0;
 }
 
-void interop::StereoTextureSender::destroyGLresources() {
+void interop::ImagePacker::destroy() {
 	mglDeleteProgram(m_shader);
+	if (m_computeShader)
+		mglDeleteProgram(m_computeShader);
+	m_computeShader = 0;
 	mglDeleteVertexArrays(1, &m_vao);
+	mglDeleteQueries(timer_queries, m_timerQueries);
 }
 
-void interop::StereoTextureSender::blitTextures(
-	const uint color_left_texture, const uint color_right_texture,
-	const uint depth_left_texture, const uint depth_right_texture,
-	const uint width, const uint height, const uint meta_data, const uint meta_data_2) {
-	GLint previous_active_texture;
-	glGetIntegerv(GL_ACTIVE_TEXTURE, &previous_active_texture);
+void interop::ImagePacker::setLayout(const StereoLayout layout) {
+	if (layout != m_layout) {
+		this->destroy();
+		this->init(layout);
+	}
+}
 
-	m_hugeFbo.bind(); // also sets viewport
-	mglUseProgram(m_shader);
-	mglBindVertexArray(m_vao);
-	// TODO: set + restore buffer reset values
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void interop::ImagePacker::setPath(const PackingPath path) {
+	m_path = path;
+	this->selectPath();
+}
+
+void interop::ImagePacker::selectPath() {
+	m_useCompute = m_computeShader && m_path != PackingPath::Fragment;
+
+	if (m_path == PackingPath::Compute && !m_computeShader)
+		std::cout << "mint: compute packing not supported by GL context, using fragment packing" << std::endl;
+}
+
+void interop::ImagePacker::pack(glFramebuffer& target, const StereoPacking& regions,
+	const uint color_textures[2], const uint depth_textures[2],
+	const float depth_near, const float depth_far) {
+	const bool copy_color = this->canCopyColor(regions, color_textures);
+	const Rect depth_sources[2] = {}; // each view has its own depth texture
+
+	if (m_useCompute)
+		this->dispatch(target, regions, color_textures, depth_textures, depth_sources, depth_near, depth_far, copy_color);
+	else
+		this->draw(target, regions, color_textures, depth_textures, depth_sources, depth_near, depth_far, copy_color);
+	if (copy_color)
+		this->copyColor(target, regions, color_textures);
+}
+
+void interop::ImagePacker::packDepth(glFramebuffer& target, const StereoPacking& regions, const uint depth_texture,
+	const Rect depth_sources[2], const float depth_near, const float depth_far) {
+	if (!regions.hasDepth())
+		return;
+
+	const uint color_textures[2] = { 0, 0 };
+	const uint depth_textures[2] = { depth_texture, depth_texture };
+
+	if (m_useCompute)
+		this->dispatch(target, regions, color_textures, depth_textures, depth_sources, depth_near, depth_far, true);
+	else
+		this->draw(target, regions, color_textures, depth_textures, depth_sources, depth_near, depth_far, true);
+}
 
+void interop::ImagePacker::bindInputs(const uint* uniform_locations, const StereoPacking& regions,
+	const uint color_textures[2], const uint depth_textures[2], const Rect depth_sources[2],
+	const float depth_near, const float depth_far) {
 	const auto bindTexture = [&](const uint texture_uniform_location,
 		const uint texture_handle,
 		const uint binding_point) {
-			mglActiveTexture(GL_TEXTURE0 +
+			setActiveTexture(GL_TEXTURE0 +
 				binding_point); // activate the texture unit first before
 			// binding texture
 			glBindTexture(GL_TEXTURE_2D, texture_handle);
 			mglUniform1i(texture_uniform_location, binding_point); // set it manually
 		};
 
-	mglUniform2i(m_uniform_locations[0], static_cast<int>(width),
-		static_cast<int>(height));
-	bindTexture(m_uniform_locations[1], color_left_texture, 0);
-	bindTexture(m_uniform_locations[2], depth_left_texture, 1);
-	bindTexture(m_uniform_locations[3], color_right_texture, 2);
-	bindTexture(m_uniform_locations[4], depth_right_texture, 3);
-	mglUniform1i(m_uniform_locations[5], static_cast<int>(meta_data));
-	mglUniform1i(m_uniform_locations[6], static_cast<int>(meta_data_2));
+	mglUniform2i(uniform_locations[0], static_cast<int>(regions.width),
+		static_cast<int>(regions.height));
+	bindTexture(uniform_locations[1], color_textures[0], 0);
+	bindTexture(uniform_locations[2], depth_textures[0], 1);
+	bindTexture(uniform_locations[3], color_textures[1], 2);
+	bindTexture(uniform_locations[4], depth_textures[1], 3);
+	mglUniform2f(uniform_locations[5], depth_near, depth_far);
+	mglUniform1i(uniform_locations[6], static_cast<int>(regions.format.depth_encoding));
+	mglUniform1i(uniform_locations[7], static_cast<int>(regions.format.depth_resolution));
+	const auto setRect = [&](const uint location, const Rect& rect) {
+		mglUniform4i(location, static_cast<int>(rect.x), static_cast<int>(rect.y),
+			static_cast<int>(rect.width), static_cast<int>(rect.height));
+		};
+	setRect(uniform_locations[8], regions.color[0]);
+	setRect(uniform_locations[9], regions.color[1]);
+	setRect(uniform_locations[10], regions.depth[0]);
+	setRect(uniform_locations[11], regions.depth[1]);
+	mglUniform2i(uniform_locations[12], static_cast<int>(depth_sources[0].x), static_cast<int>(depth_sources[0].y));
+	mglUniform2i(uniform_locations[13], static_cast<int>(depth_sources[1].x), static_cast<int>(depth_sources[1].y));
+	mglUniform1i(uniform_locations[14], static_cast<int>(regions.format.color_encoding));
+}
+
+void interop::ImagePacker::draw(glFramebuffer& target, const StereoPacking& regions,
+	const uint color_textures[2], const uint depth_textures[2], const Rect depth_sources[2],
+	const float depth_near, const float depth_far, const bool skip_color) {
+	// copied color regions are neither drawn nor part of the viewport
+	StereoPacking drawn = regions;
+	if (skip_color)
+		drawn.color[0] = drawn.color[1] = Rect{};
+
+	// only rasterize the bounding box of the regions. gl_FragCoord stays in packed image coordinates
+	uint x0 = ~0u, y0 = ~0u, x1 = 0, y1 = 0;
+	for (const Rect& r : { drawn.color[0], drawn.color[1], drawn.depth[0], drawn.depth[1] }) {
+		if (r.width == 0 || r.height == 0)
+			continue;
+		x0 = (r.x < x0) ? r.x : x0;
+		y0 = (r.y < y0) ? r.y : y0;
+		x1 = (r.x + r.width > x1) ? r.x + r.width : x1;
+		y1 = (r.y + r.height > y1) ? r.y + r.height : y1;
+	}
+	if (x1 == 0)
+		return; // everything is copied
+
+	const GLint previous_active_texture = getActiveTexture();
+
+	target.bind(); // also sets viewport
+	// depth rendered into the target itself must not be sampled while attached
+	const bool detach_depth = target.m_glTextureDepth != 0
+		&& (depth_textures[0] == target.m_glTextureDepth || depth_textures[1] == target.m_glTextureDepth);
+	if (detach_depth)
+		mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_TEXTURE_2D, 0, 0);
+	mglUseProgram(m_shader);
+	mglBindVertexArray(m_vao);
+	// color is not cleared, pixels outside the regions belong to other passes. depth is cleared
+	// so the quad passes a depth test the application may have left enabled
+	glClear(GL_DEPTH_BUFFER_BIT);
+	setViewport(x0, y0, x1 - x0, y1 - y0);
+
+	this->bindInputs(m_uniform_locations, drawn, color_textures, depth_textures, depth_sources, depth_near, depth_far);
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
 	mglBindVertexArray(0);
-	m_hugeFbo.unbind();
-	mglActiveTexture(previous_active_texture); // activate the texture unit first
+	if (detach_depth)
+		mglFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_TEXTURE_2D, target.m_glTextureDepth, 0);
+	target.unbind();
+	setActiveTexture(previous_active_texture); // activate the texture unit first
 	// before binding texture
 }
 
+void interop::ImagePacker::dispatch(glFramebuffer& target, const StereoPacking& regions,
+	const uint color_textures[2], const uint depth_textures[2], const Rect depth_sources[2],
+	const float depth_near, const float depth_far, const bool skip_color) {
+	if (skip_color && !regions.hasDepth())
+		return; // everything is copied
+
+	const GLint previous_active_texture = getActiveTexture();
+
+	mglUseProgram(m_computeShader);
+	this->bindInputs(m_compute_uniform_locations, regions, color_textures, depth_textures, depth_sources, depth_near, depth_far);
+
+	// regions 0, 1 are first and second color, 2, 3 first and second depth. empty regions return right away
+	const Rect rects[4] = { regions.color[0], regions.color[1], regions.depth[0], regions.depth[1] };
+	const bool pack_color = regions.hasColor() && !skip_color;
+	const uint first_region = pack_color ? 0 : 2;
+	const uint region_count = (pack_color && regions.hasDepth()) ? 4 : 2;
+	uint groups_x = 0, groups_y = 0;
+	// invocations of block encoded color regions encode a whole block each, so they need fewer rows
+	const ColorEncoding color_encoding = regions.format.color_encoding;
+	const bool block_color = color_encoding == ColorEncoding::BC1 || color_encoding == ColorEncoding::YCoCgDXT5;
+	for (uint r = first_region; r < first_region + region_count; r++) {
+		const uint rows = (r < 2 && block_color)
+			? (rects[r].height + colorBlockPixels(color_encoding) - 1) / colorBlockPixels(color_encoding)
+			: rects[r].height;
+		const uint x = (rects[r].width + 7) / 8;
+		const uint y = (rows + 7) / 8;
+		groups_x = (x > groups_x) ? x : groups_x;
+		groups_y = (y > groups_y) ? y : groups_y;
+	}
+	mglUniform1i(m_compute_uniform_locations[15], static_cast<int>(first_region));
+
+	mglBindImageTexture(0, target.m_glTextureRGBA8, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	mglDispatchCompute(groups_x, groups_y, region_count);
+	// the packed image is next written by the header upload and read by spout via blits, copies or readbacks
+	mglMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT
+		| GL_TEXTURE_FETCH_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+	mglBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+	setActiveTexture(previous_active_texture);
+}
+
+bool interop::ImagePacker::canCopyColor(const StereoPacking& regions, const uint color_textures[2]) {
+	if (!m_copyColor || !m_copyImageAvailable || !regions.hasColor()
+		|| regions.format.color_encoding != ColorEncoding::RGBA8)
+		return false;
+
+	// glCopyImageSubData copies raw texels, so the sources need the format of the packed image.
+	// the format is only queried for textures not seen before
+	if (m_copyableTextures.size() > 64)
+		m_copyableTextures.clear(); // forget deleted textures
+	bool copyable = true;
+	for (int i = 0; i < 2; i++) {
+		if (regions.color[i].width == 0)
+			continue;
+
+		const auto checked = m_copyableTextures.find(color_textures[i]);
+		if (checked != m_copyableTextures.end()) {
+			copyable &= checked->second;
+			continue;
+		}
+
+		GLint format = 0;
+		const GLint previous_active_texture = bindScratchTexture(color_textures[i]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		unbindScratchTexture(previous_active_texture);
+		m_copyableTextures[color_textures[i]] = (format == GL_RGBA8);
+		copyable &= (format == GL_RGBA8);
+	}
+
+	return copyable;
+}
+
+void interop::ImagePacker::copyColor(glFramebuffer& target, const StereoPacking& regions, const uint color_textures[2]) {
+	for (int i = 0; i < 2; i++) {
+		const Rect& rect = regions.color[i];
+		if (rect.width == 0)
+			continue;
+		mglCopyImageSubData(
+			color_textures[i], GL_TEXTURE_2D, 0, 0, 0, 0,
+			target.m_glTextureRGBA8, GL_TEXTURE_2D, 0, rect.x, rect.y, 0,
+			rect.width, rect.height, 1);
+	}
+}
+
+void interop::ImagePacker::beginTimer() {
+	// each query is read again timer_queries frames later, when its result is usually available.
+	// never wait for the GPU here, a result not available yet is skipped
+	const uint query = m_timerQueries[m_timerQueryIndex % timer_queries];
+	if (m_timerQueryIndex >= timer_queries) {
+		GLint available = 0;
+		mglGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			unsigned long long elapsed_ns = 0;
+			mglGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+			m_gpuMs = static_cast<float>(elapsed_ns / 1000000.0);
+			m_gpuResults++;
+		}
+	}
+	mglBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void interop::ImagePacker::endTimer() {
+	mglEndQuery(GL_TIME_ELAPSED);
+	m_timerQueryIndex++;
+}
+
+float interop::ImagePacker::getGpuMs() const {
+	return m_gpuMs;
+}
+
 #define m_socket (*static_cast<zmq::socket_t *>(m_sender.get()))
 interop::DataSender::DataSender() {
 	m_address = session_addresses.send;
@@ -774,6 +4496,18 @@ void interop::DataSender::stop() {
 		m_socket.close();
 }
 
+void interop::DataSender::stampSendTime(const std::string& filterName) {
+	if (!this->stampsSendTime(filterName))
+		m_stampedTopics.push_back(filterName);
+}
+
+bool interop::DataSender::stampsSendTime(const std::string& filterName) const {
+	for (const std::string& topic : m_stampedTopics)
+		if (topic == filterName)
+			return true;
+	return false;
+}
+
 bool interop::DataSender::send_raw(
 	std::string const& v,
 	std::string const& filterName)
@@ -803,6 +4537,8 @@ bool interop::DataSender::send_raw(
 }
 #undef m_socket
 
+static const unsigned long long clock_offset_window_ns = 5000000000ull; // DataReceiver::ClockOffset
+
 interop::DataReceiver::DataReceiver() {
 	m_address = session_addresses.receive;
 }
@@ -878,10 +4614,87 @@ while (m_worker_signal.test_and_set()) {
 				<< std::endl;
 	}
 
+	const unsigned long long receive_ns = nowNs();
+	const std::string address = address_msg.to_string();
+	const std::string content = content_msg.to_string();
+
+	// parsed only for topics that keep a history, or whose content wait() compares without the time stamp
+	// and the fields passed to ignoreOnWait(), they change with every send. outside the lock, receive() goes on
+	bool keep_history = false;
+	bool waited_on = false;
+	std::vector<std::string> ignored;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		keep_history = m_historySamples.count(address) != 0;
+		waited_on = m_waitUsed;
+		if (auto found = m_waitIgnored.find(address); waited_on && found != m_waitIgnored.end())
+			ignored = found->second;
+	}
+	const bool stamped = content.find("\"send_ns\"") != std::string::npos;
+	const bool parse = keep_history || (waited_on && (stamped || !ignored.empty()));
+	json j = parse ? json::parse(content, nullptr, false) : json();
+	unsigned long long send_ns = 0;
+	if (j.is_object() && j.contains("send_ns") && j["send_ns"].is_number_unsigned())
+		send_ns = j["send_ns"].get<unsigned long long>();
+	std::shared_ptr<const json> parsed;
+	if (keep_history && !j.is_discarded())
+		parsed = std::make_shared<const json>(j);
+
+	// senders resend unchanged data, only a changed content wakes wait()
+	std::string wait_content;
+	if (waited_on && parse && j.is_object()) {
+		j.erase("send_ns");
+		for (const std::string& field : ignored) {
+			const json::json_pointer pointer(field);
+			if (j.contains(pointer))
+				j[pointer] = nullptr;
+		}
+		wait_content = j.dump();
+	}
+	else if (waited_on)
+		wait_content = content;
+
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
-		m_messages[address_msg.to_string()] = content_msg.to_string();
+		m_messages[address] = content;
+
+		// the clocks of sender and receiver are not synchronized, but the message with the least delay is
+		// closest to having arrived right when it was sent. the minimum runs over the current and the
+		// previous window, so it follows the clocks drifting apart
+		if (send_ns) {
+			const long long delay = static_cast<long long>(receive_ns - send_ns);
+			auto& clock = m_clockOffsets[address];
+			if (!clock.window_start_ns || receive_ns - clock.window_start_ns > clock_offset_window_ns) {
+				clock.previous = clock.window_start_ns ? clock.current : delay;
+				clock.current = delay;
+				clock.window_start_ns = receive_ns;
+			}
+			else if (delay < clock.current)
+				clock.current = delay;
+		}
+
+		if (auto samples = m_historySamples.find(address); samples != m_historySamples.end()) {
+			TimedMessage message;
+			message.receive_ns = receive_ns;
+			message.send_ns = send_ns;
+			message.content = content;
+			message.parsed = std::move(parsed);
+
+			auto& history = m_history[address];
+			history.push_back(std::move(message));
+			while (history.size() > samples->second)
+				history.pop_front();
+		}
+
+		if (waited_on) {
+			auto& previous = m_waitContents[address];
+			if (previous != wait_content) {
+				previous = std::move(wait_content);
+				m_changedCount++;
+			}
+		}
 	}
+	m_messageArrived.notify_all();
 }
 
 socket.close();
@@ -911,6 +4724,55 @@ std::optional<std::string> interop::DataReceiver::receiveCopy(const std::string&
 
 	return r;
 }
+
+void interop::DataReceiver::ignoreOnWait(const std::string& filterName, const std::string& field) {
+	try {
+		static_cast<void>(json::json_pointer(field)); // throws for malformed pointers
+	}
+	catch (std::exception& e) {
+		std::cout << "mint: ignoring " << field << " of " << filterName << " failed: " << e.what() << std::endl;
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_waitIgnored[filterName].push_back(field);
+	m_waitContents.erase(filterName);
+}
+
+bool interop::DataReceiver::wait(const uint timeout_ms) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_waitUsed = true;
+	const bool arrived = m_messageArrived.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+		[&]() { return m_changedCount != m_waitedCount; });
+	m_waitedCount = m_changedCount;
+	return arrived;
+}
+
+void interop::DataReceiver::keepHistory(const std::string& filterName, const uint samples) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_historySamples[filterName] = samples;
+	auto& history = m_history[filterName];
+	while (history.size() > samples)
+		history.pop_front();
+}
+
+std::vector<interop::TimedMessage> interop::DataReceiver::history(const std::string& filterName) {
+	std::vector<TimedMessage> r;
+	long long offset = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_history.find(filterName);
+		if (found == m_history.end())
+			return r;
+		r.assign(found->second.begin(), found->second.end());
+		if (auto clock = m_clockOffsets.find(filterName); clock != m_clockOffsets.end())
+			offset = (clock->second.previous < clock->second.current) ? clock->second.previous : clock->second.current;
+	}
+
+	for (auto& m : r)
+		m.time_ns = m.send_ns ? static_cast<unsigned long long>(static_cast<long long>(m.send_ns) + offset) : m.receive_ns;
+
+	return r;
+}
 #undef m_socket
 
 // -------------------------------------------------
@@ -1197,6 +5059,8 @@ make_scalar_get(double);
     json j = v;                                                          \
 	if(maybe_extra.has_value()) \
 		j[maybe_extra.value().first] = maybe_extra.value().second; \
+	if (this->stampsSendTime(filterName)) \
+		j["send_ns"] = nowNs(); /* for DataReceiver::history() */ \
     const std::string jsonString = j.dump();                                   \
     return this->send_raw(jsonString, filterName);                             \
   }
@@ -1305,3 +5169,266 @@ bool interop::operator!=(const vec4& l, const vec4& r) {
 	return !(l == r);
 }
 
+// interop::mat4 operators, column major like glm
+interop::vec4 interop::operator*(const mat4& m, const vec4& v) {
+	return m.data[0] * v.x + m.data[1] * v.y + m.data[2] * v.z + m.data[3] * v.w;
+}
+interop::mat4 interop::operator*(const mat4& lhs, const mat4& rhs) {
+	mat4 m;
+	for (int c = 0; c < 4; c++)
+		m.data[c] = lhs * rhs.data[c];
+	return m;
+}
+interop::mat4 interop::inverse(const mat4& m) {
+	// cofactor expansion, as in glm
+	const float* a = &m.data[0].x;
+	float inv[16];
+	inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+	inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+	inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+	inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+	inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+	inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+	inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+	inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+	inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+	inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+	inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+	inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+	inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+	inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+	inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+	inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+	const float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+	mat4 r;
+	for (int c = 0; c < 4; c++)
+		r.data[c] = vec4{ inv[4 * c], inv[4 * c + 1], inv[4 * c + 2], inv[4 * c + 3] } * (1.0f / det);
+	return r;
+}
+interop::vec4 interop::unproject(const float x, const float y, const float depth, const mat4& view, const mat4& projection) {
+	const vec4 ndc{ x * 2.0f - 1.0f, y * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f };
+	const vec4 world = inverse(projection * view) * ndc;
+	return world * (1.0f / world.w);
+}
+
+// -------------------------------------------------
+// --- pose prediction
+// -------------------------------------------------
+
+// the extrapolation runs in double, the poses are absolute world positions
+namespace {
+	struct dvec3 {
+		double x = 0.0, y = 0.0, z = 0.0;
+	};
+	struct dquat {
+		double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
+	};
+}
+
+static dvec3 operator+(const dvec3& a, const dvec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+static dvec3 operator-(const dvec3& a, const dvec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static dvec3 operator*(const dvec3& a, const double s) { return { a.x * s, a.y * s, a.z * s }; }
+static double dot(const dvec3& a, const dvec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static dvec3 cross(const dvec3& a, const dvec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+static dvec3 normalize(const dvec3& a) {
+	const double l = std::sqrt(dot(a, a));
+	return l > 0.0 ? a * (1.0 / l) : a;
+}
+static dvec3 to_dvec3(const interop::vec4& v) { return { v.x, v.y, v.z }; }
+
+static dquat operator*(const dquat& a, const dquat& b) {
+	return {
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w };
+}
+static dquat conjugate(const dquat& q) { return { q.w, -q.x, -q.y, -q.z }; }
+static dvec3 rotate(const dquat& q, const dvec3& v) {
+	const dquat r = q * dquat{ 0.0, v.x, v.y, v.z } * conjugate(q);
+	return { r.x, r.y, r.z };
+}
+
+// rotation of the camera basis, columns right, up, -forward as in a view matrix
+static dquat camera_orientation(const interop::CameraView& view) {
+	const dvec3 f = normalize(to_dvec3(view.lookAtPos) - to_dvec3(view.eyePos));
+	const dvec3 r = normalize(cross(f, to_dvec3(view.camUpDir)));
+	const dvec3 u = cross(r, f);
+	const double m00 = r.x, m01 = u.x, m02 = -f.x;
+	const double m10 = r.y, m11 = u.y, m12 = -f.y;
+	const double m20 = r.z, m21 = u.z, m22 = -f.z;
+
+	dquat q;
+	const double trace = m00 + m11 + m22;
+	if (trace > 0.0) {
+		const double s = 0.5 / std::sqrt(trace + 1.0);
+		q = { 0.25 / s, (m21 - m12) * s, (m02 - m20) * s, (m10 - m01) * s };
+	}
+	else if (m00 > m11 && m00 > m22) {
+		const double s = 2.0 * std::sqrt(1.0 + m00 - m11 - m22);
+		q = { (m21 - m12) / s, 0.25 * s, (m01 + m10) / s, (m02 + m20) / s };
+	}
+	else if (m11 > m22) {
+		const double s = 2.0 * std::sqrt(1.0 + m11 - m00 - m22);
+		q = { (m02 - m20) / s, (m01 + m10) / s, 0.25 * s, (m12 + m21) / s };
+	}
+	else {
+		const double s = 2.0 * std::sqrt(1.0 + m22 - m00 - m11);
+		q = { (m10 - m01) / s, (m02 + m20) / s, (m12 + m21) / s, 0.25 * s };
+	}
+	return q;
+}
+
+// rotation vector, axis times angle, of the shortest rotation from a to b in world space
+static dvec3 rotation_between(const dquat& a, const dquat& b) {
+	dquat d = b * conjugate(a);
+	if (d.w < 0.0)
+		d = { -d.w, -d.x, -d.y, -d.z };
+	const dvec3 axis{ d.x, d.y, d.z };
+	const double s = std::sqrt(dot(axis, axis));
+	if (s < 1e-12)
+		return axis * 2.0;
+	return axis * (2.0 * std::atan2(s, d.w) / s);
+}
+
+static dquat rotation_from(const dvec3& rotation) {
+	const double angle = std::sqrt(dot(rotation, rotation));
+	if (angle < 1e-12)
+		return { 1.0, rotation.x * 0.5, rotation.y * 0.5, rotation.z * 0.5 };
+	const dvec3 axis = rotation * (std::sin(angle * 0.5) / angle);
+	return { std::cos(angle * 0.5), axis.x, axis.y, axis.z };
+}
+
+// views and times oldest first, times and horizon in seconds. the velocities are taken at the newest view
+static interop::CameraView extrapolate(const std::vector<interop::CameraView>& views, const std::vector<double>& times, const double horizon) {
+	const size_t n = views.size();
+	const interop::CameraView& newest = views[n - 1];
+
+	const auto velocity = [&](const size_t i, dvec3& linear, dvec3& angular) {
+		const double dt = times[i + 1] - times[i];
+		linear = (to_dvec3(views[i + 1].eyePos) - to_dvec3(views[i].eyePos)) * (1.0 / dt);
+		angular = rotation_between(camera_orientation(views[i]), camera_orientation(views[i + 1])) * (1.0 / dt);
+	};
+
+	dvec3 linear, angular;
+	velocity(n - 2, linear, angular);
+	dvec3 position_delta = linear * horizon;
+	dvec3 rotation_delta = angular * horizon;
+	if (n >= 3) {
+		// the velocities are those of the interval midpoints, move them to the newest view
+		dvec3 older_linear, older_angular;
+		velocity(n - 3, older_linear, older_angular);
+		const double dt = times[n - 1] - times[n - 2];
+		const double midpoints = (times[n - 1] - times[n - 3]) * 0.5;
+		const dvec3 linear_acceleration = (linear - older_linear) * (1.0 / midpoints);
+		const dvec3 angular_acceleration = (angular - older_angular) * (1.0 / midpoints);
+		position_delta = (linear + linear_acceleration * (dt * 0.5)) * horizon + linear_acceleration * (0.5 * horizon * horizon);
+		rotation_delta = (angular + angular_acceleration * (dt * 0.5)) * horizon + angular_acceleration * (0.5 * horizon * horizon);
+	}
+
+	const dquat rotation = rotation_from(rotation_delta);
+	const dvec3 eye = to_dvec3(newest.eyePos) + position_delta;
+	const dvec3 forward = to_dvec3(newest.lookAtPos) - to_dvec3(newest.eyePos);
+	const dvec3 look_at = eye + rotate(rotation, forward);
+	const dvec3 up = rotate(rotation, to_dvec3(newest.camUpDir));
+
+	interop::CameraView r = newest;
+	r.eyePos = { static_cast<float>(eye.x), static_cast<float>(eye.y), static_cast<float>(eye.z), newest.eyePos.w };
+	r.lookAtPos = { static_cast<float>(look_at.x), static_cast<float>(look_at.y), static_cast<float>(look_at.z), newest.lookAtPos.w };
+	r.camUpDir = { static_cast<float>(up.x), static_cast<float>(up.y), static_cast<float>(up.z), newest.camUpDir.w };
+	return r;
+}
+
+void interop::PosePredictor::init(DataReceiver& receiver, const std::string& topic, const Model model, const float max_horizon_ms) {
+	m_receiver = &receiver;
+	m_topic = topic;
+	m_model = model;
+	m_maxHorizonMs = max_horizon_ms;
+	m_horizonMs = 0.0f;
+	m_receiver->keepHistory(m_topic, 3);
+}
+
+// the poses of the history the model uses and their times in seconds, relative to the newest.
+// the horizon is 0 when there is nothing to extrapolate from
+template <typename Pose>
+static bool predictor_history(interop::PosePredictor& predictor, const unsigned long long target_ns,
+	std::vector<Pose>& poses, std::vector<double>& times, double& horizon) {
+	predictor.m_horizonMs = 0.0f;
+	horizon = 0.0;
+	if (!predictor.m_receiver)
+		return false;
+
+	auto history = predictor.m_receiver->history(predictor.m_topic);
+	const size_t samples = predictor.m_model == interop::PosePredictor::Model::ConstantAcceleration ? 3 : 2;
+	if (history.size() > samples)
+		history.erase(history.begin(), history.end() - samples);
+
+	for (const auto& m : history) {
+		if (!m.parsed)
+			continue;
+		try {
+			poses.push_back(static_cast<const json*>(m.parsed.get())->get<Pose>());
+			times.push_back(static_cast<double>(static_cast<long long>(m.time_ns - history.back().time_ns)) * 1e-9);
+		}
+		catch (std::exception&) {
+		}
+	}
+	if (poses.empty())
+		return false;
+
+	// poses sent at the same time carry no motion
+	for (size_t i = 1; i < times.size(); i++)
+		if (times[i] <= times[i - 1]) {
+			poses.erase(poses.begin(), poses.begin() + i);
+			times.erase(times.begin(), times.begin() + i);
+			i = 0;
+		}
+
+	// the horizon is clamped to its limit, a slow frame or late pose does not throw the camera far ahead
+	double age_ms = static_cast<double>(static_cast<long long>(target_ns - history.back().time_ns)) * 1e-6 - times.back() * 1e3;
+	age_ms = age_ms > predictor.m_maxHorizonMs ? predictor.m_maxHorizonMs : age_ms;
+	if (poses.size() >= 2 && age_ms > 0.0) {
+		// a sender that stopped mid motion would leave the camera ahead of its last pose for good. once the
+		// newest pose is two send intervals old the horizon fades out over one more interval
+		const double interval_ms = (times.back() - times[times.size() - 2]) * 1e3;
+		const double since_ms = static_cast<double>(static_cast<long long>(nowNs() - history.back().time_ns)) * 1e-6 - times.back() * 1e3;
+		double fade = 1.0 - (since_ms - 2.0 * interval_ms) / interval_ms;
+		fade = (fade < 0.0) ? 0.0 : (fade > 1.0 ? 1.0 : fade);
+		horizon = age_ms * fade * 1e-3;
+		predictor.m_horizonMs = static_cast<float>(age_ms * fade);
+	}
+	return true;
+}
+
+bool interop::PosePredictor::predict(const unsigned long long target_ns, StereoCameraViewRelative& pose) {
+	std::vector<StereoCameraViewRelative> poses;
+	std::vector<double> times;
+	double horizon = 0.0;
+	if (!predictor_history(*this, target_ns, poses, times, horizon))
+		return false;
+
+	pose = poses.back();
+	if (horizon <= 0.0)
+		return true;
+
+	std::vector<CameraView> left, right;
+	for (const auto& p : poses) {
+		left.push_back(p.leftEyeView);
+		right.push_back(p.rightEyeView);
+	}
+	pose.leftEyeView = extrapolate(left, times, horizon);
+	pose.rightEyeView = extrapolate(right, times, horizon);
+	return true;
+}
+
+bool interop::PosePredictor::predict(const unsigned long long target_ns, CameraView& pose) {
+	std::vector<CameraView> poses;
+	std::vector<double> times;
+	double horizon = 0.0;
+	if (!predictor_history(*this, target_ns, poses, times, horizon))
+		return false;
+
+	pose = horizon > 0.0 ? extrapolate(poses, times, horizon) : poses.back();
+	return true;
+}
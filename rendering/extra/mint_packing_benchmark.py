@@ -0,0 +1,41 @@
+import subprocess
+
+gpuname = "TitanRTX"
+
+pack_paths = ["fragment", "compute"]
+color_copy = {"copy": "", "shader": "--no-color-copy"}
+# compressed color is always packed in the shader, color copy does not apply
+color_encodings = ["rgba8", "bc1", "ycocg-dxt5", "yuv420"]
+
+image_size = "800 600"
+full_hd_size = "1920 1080"
+vive_pro_image_size = "1998 2130"
+image_sizes = [image_size, full_hd_size, vive_pro_image_size]
+
+benchmark_sec = "20"
+
+# rendering measures the GPU time of packing the stereo texture and exits on its own,
+# no steering is needed as the image size is fixed
+def result_file(p, c, e, size):
+    return "mint_packing_{}_{}+{}+{}_{}.txt".format(gpuname, p, c, e, size.replace(" ", "x"))
+
+def runs():
+    for size in image_sizes:
+        for p in pack_paths:
+            for e in color_encodings:
+                for c, c_opt in color_copy.items():
+                    if e != "rgba8" and c != "shader":
+                        continue
+                    yield size, p, e, c, c_opt
+
+for size, p, e, c, c_opt in runs():
+    print("BENCHMARK: {} packing, {} color {} at {}".format(p, e, c, size))
+    subprocess.run("rendering.exe --texture-send=stereo --render-ms=0 --image-size {} --pack-path={} --color-encoding={} {} --pack-benchmark={} --pack-benchmark-file={}".format(size, p, e, c_opt, benchmark_sec, result_file(p, c, e, size)), shell=True)
+
+# PackedBytes shows the bytes read back and uploaded per frame by the cpu and memshare spout modes,
+# ColorPSNR the quality of the color encoding
+for size, p, e, c, c_opt in runs():
+    with open(result_file(p, c, e, size)) as f:
+        print(f.read().splitlines()[-1])
+
+print("DONE")
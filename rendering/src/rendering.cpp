@@ -14,6 +14,9 @@
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <charconv>
 
 #include <CLI/CLI.hpp>
 
@@ -24,6 +27,12 @@ glm::vec4 toGlm(const mint::vec4& v) {
 mint::vec4 toInterop(const glm::vec3& v) {
 	return mint::vec4{ v.x, v.y, v.z, 0.0f };
 }
+mint::vec4 toInterop(const glm::vec4& v) {
+	return mint::vec4{ v.x, v.y, v.z, v.w };
+}
+mint::mat4 toInterop(const glm::mat4& m) {
+	return mint::mat4{ toInterop(m[0]), toInterop(m[1]), toInterop(m[2]), toInterop(m[3]) };
+}
 glm::mat4 toGlm(const mint::mat4& m) {
 	return glm::mat4{
 		toGlm(m.data[0]),
@@ -133,6 +142,45 @@ static const char* fragment_shader_source = R"(
 	}\
 )";
 
+// both eyes in one instanced draw, instance i renders eye i. with viewport arrays every eye has its own
+// viewport, otherwise the viewport covers both eyes and each eye is squeezed into its part of it
+static const char* single_pass_vertex_shader_source = R"(
+#if VIEWPORT_ARRAY
+	#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+	uniform mat4 MVP[2];
+	uniform vec4 eye_clip[2]; // scale xy, offset xy of the eyes within the viewport covering both
+	in vec3 vCol;
+	in vec3 vPos;
+	out vec3 color;
+	out float gl_ClipDistance[4];
+	void main()
+	{
+		int eye = gl_InstanceID;
+		gl_Position = MVP[eye] * vec4(vPos, 1.0);
+#if VIEWPORT_ARRAY
+		gl_ViewportIndex = eye;
+#else
+		vec4 p = gl_Position;
+		gl_ClipDistance[0] = p.w + p.x;
+		gl_ClipDistance[1] = p.w - p.x;
+		gl_ClipDistance[2] = p.w + p.y;
+		gl_ClipDistance[3] = p.w - p.y;
+		gl_Position.xy = p.xy * eye_clip[eye].xy + eye_clip[eye].zw * p.w;
+#endif
+		color = vCol;
+	}\
+)";
+
+static const char* single_pass_fragment_shader_source = R"(
+	in vec3 color;
+	out vec4 FragColor;
+	void main()
+	{
+		FragColor = vec4(color, 1.0);
+	}\
+)";
+
 static void glfw_error_callback(int error, const char* description)
 {
 	std::cout << "GLFW Error " << error << ": " << description << std::endl;
@@ -191,18 +239,20 @@ enum class TextureSenderMode {
 	All = 0,
 	Single,
 	Stereo,
+	MultiView,
 };
 struct TextureSenders {
 	TextureSenderMode mode;
 	mint::StereoTextureSender stereotextureSender;
+	mint::MultiViewTextureSender multiviewtextureSender;
 	mint::TextureSender lefttextureSender;
 	mint::TextureSender righttextureSender;
 
-	explicit TextureSenders(TextureSenderMode m) : mode{ m } {
+	explicit TextureSenders(TextureSenderMode m, const mint::StereoPackingFormat format = {}) : mode{ m } {
 		switch (mode)
 		{
 		case TextureSenderMode::All:
-			stereotextureSender.init();
+			stereotextureSender.init("", 1, 1, format);
 			lefttextureSender.init(mint::ImageType::LeftEye);
 			righttextureSender.init(mint::ImageType::RightEye);
 			break;
@@ -211,7 +261,10 @@ struct TextureSenders {
 			righttextureSender.init(mint::ImageType::RightEye);
 			break;
 		case TextureSenderMode::Stereo:
-			stereotextureSender.init();
+			stereotextureSender.init("", 1, 1, format);
+			break;
+		case TextureSenderMode::MultiView:
+			multiviewtextureSender.init("", 2, 1, 1, format);
 			break;
 		default:
 			break;
@@ -233,6 +286,9 @@ struct TextureSenders {
 		case TextureSenderMode::Stereo:
 			stereotextureSender.destroy();
 			break;
+		case TextureSenderMode::MultiView:
+			multiviewtextureSender.destroy();
+			break;
 		default:
 			break;
 		}
@@ -251,13 +307,46 @@ int main(int argc, char** argv)
 		->transform(CLI::CheckedTransformer(map_zmq, CLI::ignore_case));
 
 	mint::ImageProtocol spout_protocol = mint::ImageProtocol::GPU;
-	std::map<std::string, mint::ImageProtocol> map_spout = { {"gpu", mint::ImageProtocol::GPU}, {"cpu", mint::ImageProtocol::CPU}, {"memshare", mint::ImageProtocol::MemShare} };
+	std::map<std::string, mint::ImageProtocol> map_spout = { {"gpu", mint::ImageProtocol::GPU}, {"cpu", mint::ImageProtocol::CPU}, {"memshare", mint::ImageProtocol::MemShare}, {"network", mint::ImageProtocol::Network} };
 	app.add_option("--spout", spout_protocol, "Spout protocol to use for texture sharing.")
 		->transform(CLI::CheckedTransformer(map_spout, CLI::ignore_case));
 
+	mint::NetworkImageSettings network_image;
+	app.add_option("--image-address", network_image.address, "Address the network image transport (--spout network) binds to, default tcp://*:12347");
+	app.add_option("--image-max-fps", network_image.max_fps, "Limit of frames per second sent by the network image transport, 0 for no limit");
+	app.add_option("--image-keyframe-s", network_image.keyframe_interval_s, "Seconds between network frames holding all tiles instead of only the changed ones");
+
 	float rendering_fps_target_ms = 0.0;
 	auto* fps_opt_opt = app.add_option("-r,--render-ms", rendering_fps_target_ms, "Frame time in miliseconds to target via render loop delay");
 
+	float dynamic_resolution_ms = 0.0f;
+	app.add_option("--dynamic-resolution", dynamic_resolution_ms, "If positive, frame time in milliseconds to hold by scaling the render resolution below the requested image size");
+	float dynamic_resolution_min_scale = 0.5f;
+	app.add_option("--dynamic-resolution-min", dynamic_resolution_min_scale, "Lowest render resolution relative to the requested image size for --dynamic-resolution");
+
+	bool render_on_demand = false;
+	app.add_flag("--render-on-demand", render_on_demand, "Render only when the camera or projection changed or the \"mintanimate\" topic is set, otherwise wait for data and keep the last published frame");
+	int on_demand_timeout_ms = 100;
+	app.add_option("--on-demand-timeout", on_demand_timeout_ms, "Milliseconds to wait for data between checks when --render-on-demand has nothing to render");
+
+	bool late_latch = false;
+	app.add_flag("--late-latch", late_latch, "Read the camera again after the --render-ms delay, right before drawing");
+
+	float pose_prediction_ms = 0.0f;
+	app.add_option("--pose-prediction", pose_prediction_ms, "If positive, milliseconds from reading the camera until the frame is displayed, the camera is extrapolated from the last poses steering sent to that time");
+	mint::PosePredictor::Model pose_prediction_model = mint::PosePredictor::Model::ConstantVelocity;
+	std::map<std::string, mint::PosePredictor::Model> map_pose_prediction = { {"velocity", mint::PosePredictor::Model::ConstantVelocity}, {"acceleration", mint::PosePredictor::Model::ConstantAcceleration} };
+	app.add_option("--pose-prediction-model", pose_prediction_model, "Motion model of --pose-prediction. Options: velocity (last two poses), acceleration (last three poses)")
+		->transform(CLI::CheckedTransformer(map_pose_prediction, CLI::ignore_case));
+	float pose_prediction_max_ms = 0.0f;
+	app.add_option("--pose-prediction-max", pose_prediction_max_ms, "Milliseconds --pose-prediction extrapolates past the newest pose at most, when steering stalls the camera stays there. Default twice --pose-prediction");
+
+	int max_frames_in_flight = 0;
+	app.add_option("--max-frames-in-flight", max_frames_in_flight, "If positive, frames the stereo texture may run ahead of the last one steering acknowledged as displayed. Needs --texture-send=stereo, all or multiview");
+
+	int progressive_levels = 0;
+	app.add_option("--progressive", progressive_levels, "If positive, number of refinement levels: frames start at 1/2^(levels-1) resolution when the camera moves and double it each frame while the camera stays, rendering stops at full resolution. The shared images keep their size at every level. Not with --single-pass-stereo");
+
 	std::vector<int> image_size = { 800, 600 };
 	auto* image_size_used = app.add_option("-i,--image-size", image_size, "Size of shared image: -i width height")->expected(2);
 
@@ -265,10 +354,44 @@ int main(int argc, char** argv)
 	app.add_flag("--vsync", vsync, "Whether to activate vsync for this process");
 
 	TextureSenderMode texture_sender_mode = TextureSenderMode::All;
-	std::map<std::string, TextureSenderMode> map_txtrsend = { {"all", TextureSenderMode::All}, {"single", TextureSenderMode::Single}, {"stereo", TextureSenderMode::Stereo} };
-	app.add_option("--texture-send", texture_sender_mode, "Whether to send single left+right textures, stereo texture, or all")
+	std::map<std::string, TextureSenderMode> map_txtrsend = { {"all", TextureSenderMode::All}, {"single", TextureSenderMode::Single}, {"stereo", TextureSenderMode::Stereo}, {"multiview", TextureSenderMode::MultiView} };
+	app.add_option("--texture-send", texture_sender_mode, "Whether to send single left+right textures, stereo texture, all, or the eyes as views of a multi view atlas")
 		->transform(CLI::CheckedTransformer(map_txtrsend, CLI::ignore_case));
 
+	mint::StereoPackingFormat packing_format;
+	std::map<std::string, mint::DepthEncoding> map_depth_encoding = { {"float32", mint::DepthEncoding::Float32}, {"linear24", mint::DepthEncoding::Linear24}, {"linear16", mint::DepthEncoding::Linear16} };
+	app.add_option("--depth-encoding", packing_format.depth_encoding, "Depth encoding of the stereo texture. Options: float32, linear24, linear16")
+		->transform(CLI::CheckedTransformer(map_depth_encoding, CLI::ignore_case));
+	std::map<std::string, mint::DepthResolution> map_depth_resolution = { {"full", mint::DepthResolution::Full}, {"half", mint::DepthResolution::Half}, {"quarter", mint::DepthResolution::Quarter} };
+	app.add_option("--depth-resolution", packing_format.depth_resolution, "Depth resolution of the stereo texture. Options: full, half, quarter")
+		->transform(CLI::CheckedTransformer(map_depth_resolution, CLI::ignore_case));
+	std::map<std::string, mint::StereoLayout> map_stereo_layout = { {"color-depth", mint::StereoLayout::ColorDepth}, {"color-side-by-side", mint::StereoLayout::ColorSideBySide}, {"color-top-bottom", mint::StereoLayout::ColorTopBottom}, {"depth-only", mint::StereoLayout::DepthOnly} };
+	app.add_option("--stereo-layout", packing_format.layout, "Layout of the stereo texture. Options: color-depth, color-side-by-side, color-top-bottom, depth-only")
+		->transform(CLI::CheckedTransformer(map_stereo_layout, CLI::ignore_case));
+	std::map<std::string, mint::ColorEncoding> map_color_encoding = { {"rgba8", mint::ColorEncoding::RGBA8}, {"bc1", mint::ColorEncoding::BC1}, {"ycocg-dxt5", mint::ColorEncoding::YCoCgDXT5}, {"yuv420", mint::ColorEncoding::YUV420} };
+	app.add_option("--color-encoding", packing_format.color_encoding, "Color encoding of the stereo texture, all but rgba8 compress color on the GPU. Options: rgba8, bc1, ycocg-dxt5, yuv420")
+		->transform(CLI::CheckedTransformer(map_color_encoding, CLI::ignore_case));
+
+	mint::PackingPath packing_path = mint::PackingPath::Auto;
+	std::map<std::string, mint::PackingPath> map_packing_path = { {"auto", mint::PackingPath::Auto}, {"fragment", mint::PackingPath::Fragment}, {"compute", mint::PackingPath::Compute} };
+	app.add_option("--pack-path", packing_path, "How the stereo texture is packed on the GPU. Options: auto, fragment, compute")
+		->transform(CLI::CheckedTransformer(map_packing_path, CLI::ignore_case));
+
+	bool single_pass_stereo = false;
+	app.add_flag("--single-pass-stereo", single_pass_stereo, "Render both eyes in one instanced pass straight into the stereo texture, which then only needs depth encoding. Needs --texture-send=stereo, a stereo layout with color and rgba8 color encoding");
+
+	bool no_color_copy = false;
+	app.add_flag("--no-color-copy", no_color_copy, "Pack color of the stereo texture in the shader instead of copying it with glCopyImageSubData");
+
+	mint::Foveation foveation;
+	app.add_option("--foveation", foveation.periphery_scale, "Pack each eye of the stereo texture as a full resolution inset around its center next to the whole eye downsampled by this factor, 1 for no foveation");
+	app.add_option("--foveation-inset", foveation.inset_size, "Size of the full resolution inset relative to the eye image, default 1/3");
+
+	float pack_benchmark_sec = 0.0f;
+	app.add_option("--pack-benchmark", pack_benchmark_sec, "If positive, measure GPU time of stereo texture packing for this many seconds, then exit");
+	std::filesystem::path pack_benchmark_file = "";
+	app.add_option("--pack-benchmark-file", pack_benchmark_file, "Output file for packing measurements");
+
 	auto txtr_to_string = [](TextureSenderMode mode) -> std::string {
 		switch (mode)
 		{
@@ -281,6 +404,9 @@ int main(int argc, char** argv)
 		case TextureSenderMode::Stereo:
 			return "stereo texture";
 			break;
+		case TextureSenderMode::MultiView:
+			return "multi view atlas";
+			break;
 		default:
 			break;
 		}
@@ -301,8 +427,9 @@ int main(int argc, char** argv)
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	int initialWidth = 640;
-	int initialHeight = 480;
+	// a given image size is kept, otherwise the projection steering sends sets it
+	int initialWidth = (image_size_used->count() > 0) ? image_size[0] : 640;
+	int initialHeight = (image_size_used->count() > 0) ? image_size[1] : 480;
 	std::string window_name = "mint rendering";
 	window = glfwCreateWindow(initialWidth, initialHeight, window_name.c_str(), NULL, NULL);
 	if (!window)
@@ -343,6 +470,36 @@ int main(int argc, char** argv)
 	vpos_location = glGetAttribLocation(program, "vPos");
 	vcol_location = glGetAttribLocation(program, "vCol");
 
+	// the vertex shader can select the viewport itself with ARB_shader_viewport_layer_array
+	bool has_viewport_array = false;
+	GLint extension_count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+	for (GLint i = 0; i < extension_count; i++)
+		has_viewport_array |= std::string((const char*)glGetStringi(GL_EXTENSIONS, i)) == "GL_ARB_shader_viewport_layer_array";
+
+	const std::string single_pass_header = std::string("#version 410 core\n#define VIEWPORT_ARRAY ") + (has_viewport_array ? "1" : "0") + "\n";
+	const char* single_pass_vertex_sources[] = { single_pass_header.c_str(), single_pass_vertex_shader_source };
+	const char* single_pass_fragment_sources[] = { single_pass_header.c_str(), single_pass_fragment_shader_source };
+	vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex_shader, 2, single_pass_vertex_sources, NULL);
+	glCompileShader(vertex_shader);
+	fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragment_shader, 2, single_pass_fragment_sources, NULL);
+	glCompileShader(fragment_shader);
+	GLuint single_pass_program = glCreateProgram();
+	glAttachShader(single_pass_program, vertex_shader);
+	glAttachShader(single_pass_program, fragment_shader);
+	// same attribute locations as program, so both draw from the same vertex arrays
+	glBindAttribLocation(single_pass_program, vpos_location, "vPos");
+	glBindAttribLocation(single_pass_program, vcol_location, "vCol");
+	glLinkProgram(single_pass_program);
+
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	const GLint single_pass_mvp_location = glGetUniformLocation(single_pass_program, "MVP");
+	const GLint single_pass_eye_clip_location = glGetUniformLocation(single_pass_program, "eye_clip");
+
 	const auto registerVertexAttributes = [&]() {
 		glEnableVertexAttribArray(vpos_location);
 		glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -363,12 +520,16 @@ int main(int argc, char** argv)
 	bbox.unbind();
 	bbox.setElements(bboxElements);
 
+	mint::setNetworkImageSettings(network_image);
 	mint::init(mint::Role::Rendering, zmq_protocol, spout_protocol);
 
 	mint::glFramebuffer fbo_left;
 	fbo_left.init();
 	mint::glFramebuffer fbo_right;
 	fbo_right.init();
+	// lower refinement levels are rendered here and stretched into the eye framebuffers
+	mint::glFramebuffer fbo_refine;
+	fbo_refine.init();
 
 	mint::DataReceiver data_receiver;
 	data_receiver.start();
@@ -389,7 +550,62 @@ int main(int argc, char** argv)
 		mint::vec4{2.0f * offset.x, 2.0f * offset.y, 2.0f * offset.z, 1.0f}
 	};
 
-	TextureSenders textureSender{ texture_sender_mode };
+	TextureSenders textureSender{ texture_sender_mode, packing_format };
+	textureSender.stereotextureSender.setPackingPath(packing_path);
+	textureSender.stereotextureSender.m_packer.m_copyColor = !no_color_copy;
+	textureSender.stereotextureSender.setFoveation(foveation);
+	std::cout << "rendering packs stereo texture with " << (textureSender.stereotextureSender.m_packer.m_useCompute ? "compute" : "fragment") << " shader" << std::endl;
+	std::vector<float> pack_gpu_ms;
+	mint::uint pack_gpu_results = 0;
+	textureSender.stereotextureSender.setDepthRange(0.1f, 10.0f);
+	textureSender.multiviewtextureSender.setPackingPath(packing_path);
+	textureSender.multiviewtextureSender.setDepthRange(0.1f, 10.0f);
+
+	if (single_pass_stereo && (texture_sender_mode != TextureSenderMode::Stereo || !textureSender.stereotextureSender.m_packing.hasColor()
+		|| packing_format.color_encoding != mint::ColorEncoding::RGBA8 || foveation.periphery_scale > 1)) {
+		std::cout << "rendering: single pass stereo needs --texture-send=stereo, a stereo layout with color, rgba8 color encoding and no foveation, rendering each eye separately" << std::endl;
+		single_pass_stereo = false;
+	}
+	// the eyes are rendered straight into the packed image, there is no target to stretch the lower levels from
+	if (single_pass_stereo && progressive_levels > 0) {
+		std::cout << "rendering: progressive refinement is not supported with single pass stereo, rendering every frame at full resolution" << std::endl;
+		progressive_levels = 0;
+	}
+	if (single_pass_stereo)
+		std::cout << "rendering both eyes in a single pass " << (has_viewport_array ? "with viewport array" : "with clip distances") << std::endl;
+
+	mint::DynamicResolution dynamic_resolution;
+	if (dynamic_resolution_ms > 0.0f) {
+		dynamic_resolution.init(dynamic_resolution_ms, dynamic_resolution_min_scale);
+		std::cout << "rendering scales its resolution to hold " << dynamic_resolution_ms << " ms per frame" << std::endl;
+	}
+	if (progressive_levels > 0)
+		std::cout << "rendering refines each camera pose over " << progressive_levels << " levels" << std::endl;
+	if (render_on_demand)
+		std::cout << "rendering only when the camera or projection changes" << std::endl;
+	// steering resends its camera every frame with a new frame id in eyePos.w of the left eye, that alone is no camera move
+	data_receiver.ignoreOnWait(mint::to_data_name(stereoCameraView), "/leftEyeView/eyePos/w");
+
+	mint::PosePredictor pose_predictor;
+	if (pose_prediction_ms > 0.0f) {
+		// the newest pose is already some transport delay old when it is read, the limit leaves room for that
+		const float max_horizon_ms = pose_prediction_max_ms > 0.0f ? pose_prediction_max_ms : 2.0f * pose_prediction_ms;
+		pose_predictor.init(data_receiver, mint::to_data_name(stereoCameraView), pose_prediction_model, max_horizon_ms);
+		std::cout << "rendering predicts the camera " << pose_prediction_ms << " ms ahead" << std::endl;
+	}
+	const auto predictCamera = [&]() {
+		if (pose_prediction_ms > 0.0f)
+			pose_predictor.predict(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::high_resolution_clock::now().time_since_epoch()).count()) + static_cast<unsigned long long>(pose_prediction_ms * 1e6f), stereoCameraView);
+		};
+
+	// steering only acknowledges frames with a header, single textures would never get their credit back
+	if (max_frames_in_flight > 0 && texture_sender_mode == TextureSenderMode::Single) {
+		std::cout << "rendering: --max-frames-in-flight needs --texture-send=stereo, all or multiview, sending without credits" << std::endl;
+		max_frames_in_flight = 0;
+	}
+	mint::FrameCredits frame_credits;
+	frame_credits.init(static_cast<mint::uint>(max_frames_in_flight > 0 ? max_frames_in_flight : 0));
 
 	mint::CameraView defaultCameraView;
 	defaultCameraView.eyePos = toInterop(glm::vec3{ 0.0f, 0.0f, 3.0f });
@@ -404,6 +620,23 @@ int main(int argc, char** argv)
 
 	int fbo_width = 0, fbo_height = 0;
 	glfwGetFramebufferSize(window, &fbo_width, &fbo_height);
+	if (image_size_used->count() > 0) {
+		fbo_width = initialWidth;
+		fbo_height = initialHeight;
+		std::cout << "texture size: " << fbo_width << "x" << fbo_height << std::endl;
+	}
+
+	// pose of the last rendered frame, the zero projection makes the first frame render
+	int refinement_level = 0;
+	auto rendered_camera_view = stereoCameraView;
+	glm::mat4 rendered_projection{ 0.0f };
+	int scene_animation = 0;
+	// eyePos.w of the left eye carries the steering frame id, only the positions tell a camera move
+	const auto sameCameraView = [](const mint::CameraView& a, const mint::CameraView& b) {
+		return glm::vec3(toGlm(a.eyePos)) == glm::vec3(toGlm(b.eyePos))
+			&& glm::vec3(toGlm(a.lookAtPos)) == glm::vec3(toGlm(b.lookAtPos))
+			&& glm::vec3(toGlm(a.camUpDir)) == glm::vec3(toGlm(b.camUpDir));
+		};
 
 	using namespace std::chrono_literals;
 	using FpMilliseconds = std::chrono::duration<float, std::chrono::milliseconds::period>;
@@ -442,18 +675,18 @@ int main(int argc, char** argv)
 		if (frame_timing_index == 0) {
 			float frame_ms = fps_average();
 			std::string fps_info = " | " + std::to_string(frame_ms) + " ms/f | " + std::to_string(1000.0f / frame_ms) + " fps";
-			std::string title = window_name + fps_info;
+			std::string gl_info = " | " + std::to_string(mint::getGlStateStatistics().queries_saved) + " GL queries saved/f";
+			std::string pack_info = " | pack " + std::to_string(textureSender.stereotextureSender.getPackGpuMs()) + " ms GPU, "
+				+ std::to_string(textureSender.stereotextureSender.getTargetWaits()) + " waits";
+			std::string scale_info = (dynamic_resolution_ms > 0.0f) ? " | scale " + std::to_string(dynamic_resolution.getScale()) : "";
+			std::string credit_info = frame_credits.m_acknowledgedNs
+				? " | " + std::to_string(frame_credits.inFlight()) + " in flight, " + std::to_string(frame_credits.m_droppedFrames) + " dropped"
+				: "";
+			std::string title = window_name + fps_info + gl_info + pack_info + scale_info + credit_info;
 			glfwSetWindowTitle(window, title.c_str());
 		}
 		frame_timing_index = (frame_timing_index + 1) % frame_durations.size();
 
-		ratio = fbo_width / (float)fbo_height;
-		// default framebuffer
-		glViewport(0, 0, fbo_width, fbo_height);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		data_sender.send(bboxCorners, mint::to_data_name(bboxCorners), std::pair{ std::string("timestamp"), current_time_string });
-
 		const auto getModelMatrix = [](mint::ModelPose& mp) -> glm::mat4 {
 			const glm::vec4 modelTranslate = toGlm(mp.translation);
 			const glm::vec4 modelScale = toGlm(mp.scale);
@@ -474,11 +707,13 @@ int main(int argc, char** argv)
 				cameraProjection.aspect,
 				cameraProjection.nearClipPlane,
 				cameraProjection.farClipPlane);
+			textureSender.stereotextureSender.setDepthRange(cameraProjection.nearClipPlane, cameraProjection.farClipPlane);
+			textureSender.multiviewtextureSender.setDepthRange(cameraProjection.nearClipPlane, cameraProjection.farClipPlane);
 
-			hasNewWindowSize =
-				(fbo_width != cameraProjection.pixelWidth)
-				|| (fbo_height != cameraProjection.pixelHeight);
-			if (hasNewWindowSize && image_size_used->count() == 0) {
+			hasNewWindowSize = image_size_used->count() == 0
+				&& ((fbo_width != cameraProjection.pixelWidth)
+				|| (fbo_height != cameraProjection.pixelHeight));
+			if (hasNewWindowSize) {
 				fbo_width = cameraProjection.pixelWidth;
 				fbo_height = cameraProjection.pixelHeight;
 				glfwSetWindowSize(window, fbo_width, fbo_height);
@@ -487,6 +722,59 @@ int main(int argc, char** argv)
 		}
 
 		received_data |= data_receiver.receive<mint::StereoCameraViewRelative>(stereoCameraView);
+		predictCamera();
+
+		// an animated scene changes without any input, apps set the flag while their scene moves
+		data_receiver.receive(scene_animation, "mintanimate");
+
+		// steering acknowledges the frame_sequence of the stereo frames it displayed
+		mint::uint acknowledged_frame = 0;
+		auto dropped_frames = std::make_optional(std::pair<std::string, std::string>{ "dropped", "0" });
+		if (data_receiver.receive(acknowledged_frame, "mintframeack", dropped_frames)) {
+			// a malformed count only costs the drop statistics, from_chars leaves it at 0
+			mint::uint dropped = 0;
+			const std::string& count = dropped_frames.value().second;
+			std::from_chars(count.data(), count.data() + count.size(), dropped);
+			frame_credits.acknowledge(acknowledged_frame, dropped);
+		}
+
+		// without credit the scene changes stay pending until steering catches up
+		bool render_frame = false;
+		if (frame_credits.canSend()) {
+			const bool scene_changed = scene_animation != 0 || hasNewWindowSize || projection != rendered_projection
+				|| !sameCameraView(stereoCameraView.leftEyeView, rendered_camera_view.leftEyeView)
+				|| !sameCameraView(stereoCameraView.rightEyeView, rendered_camera_view.rightEyeView);
+			if (scene_changed) {
+				rendered_camera_view = stereoCameraView;
+				rendered_projection = projection;
+			}
+			render_frame = scene_changed || !render_on_demand;
+			if (progressive_levels > 0) {
+				// refinement restarts when the scene changes and stops once the final level is published
+				render_frame = true;
+				if (scene_changed)
+					refinement_level = 0;
+				else if (refinement_level + 1 < progressive_levels)
+					refinement_level++;
+				else
+					render_frame = false;
+			}
+		}
+		if (!render_frame) {
+			// receivers keep showing the last published frame, the gpu is free until new data arrives
+			data_receiver.wait(static_cast<mint::uint>(on_demand_timeout_ms));
+			glfwPollEvents();
+			current_time = std::chrono::high_resolution_clock::now(); // the wait does not count into the frame time
+			continue;
+		}
+
+		ratio = fbo_width / (float)fbo_height;
+		// default framebuffer
+		glViewport(0, 0, fbo_width, fbo_height);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		mint::syncGlState(); // once per frame, interop works from cached bindings afterwards
+
+		data_sender.send(bboxCorners, mint::to_data_name(bboxCorners), std::pair{ std::string("timestamp"), current_time_string });
 
 		if (rendering_fps_target_ms > 0.0f) {
 			auto diff = rendering_fps_target_ms - last_frame_duration;
@@ -495,22 +783,60 @@ int main(int argc, char** argv)
 			std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(last_fps_wait));
 		}
 
-		const auto render = [&](mint::CameraView& camView, mint::glFramebuffer& fbo, mint::TextureSender* ts)
+		if (late_latch) {
+			// the camera may have moved during the pacing delay, draw with the freshest one.
+			// the refinement levels rendered so far belong to the previous pose
+			data_receiver.receive<mint::StereoCameraViewRelative>(stereoCameraView);
+			predictCamera();
+			if (!sameCameraView(stereoCameraView.leftEyeView, rendered_camera_view.leftEyeView)
+				|| !sameCameraView(stereoCameraView.rightEyeView, rendered_camera_view.rightEyeView))
+				refinement_level = 0;
+			rendered_camera_view = stereoCameraView;
+		}
+
+		const auto render_start_ns = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+
+		// the eyes are rendered at a fraction of the requested size under dynamic resolution, receivers stretch them.
+		// with progressive refinement the controller only measures level 0, the frames rendered while the camera moves
+		const bool measure_frame = dynamic_resolution_ms > 0.0f && refinement_level == 0;
+		if (measure_frame)
+			dynamic_resolution.beginFrame();
+		const int render_width = (dynamic_resolution_ms > 0.0f) ? static_cast<int>(dynamic_resolution.scaled(fbo_width)) : fbo_width;
+		const int render_height = (dynamic_resolution_ms > 0.0f) ? static_cast<int>(dynamic_resolution.scaled(fbo_height)) : fbo_height;
+		// lower refinement levels are rendered smaller and stretched to the render size, so the packed image
+		// keeps its size while the camera rests. the metadata tells the resolution the frame really has
+		const int refinement_divisor = (progressive_levels > 0) ? 1 << (progressive_levels - 1 - refinement_level) : 1;
+		const int level_width = (render_width / refinement_divisor > 1) ? render_width / refinement_divisor : 1;
+		const int level_height = (render_height / refinement_divisor > 1) ? render_height / refinement_divisor : 1;
+		const bool refining = level_width != render_width || level_height != render_height;
+		textureSender.stereotextureSender.setRenderScale(((dynamic_resolution_ms > 0.0f) ? dynamic_resolution.getScale() : 1.0f)
+			* static_cast<float>(level_width) / static_cast<float>(render_width));
+		textureSender.stereotextureSender.setRefinement(static_cast<mint::uint>(refinement_level), static_cast<mint::uint>(progressive_levels > 0 ? progressive_levels : 0));
+
+		const auto getViewMatrix = [](const mint::CameraView& camView) -> glm::mat4 {
+			return glm::lookAt(
+				glm::vec3(toGlm(camView.eyePos)),
+				glm::vec3(toGlm(camView.lookAtPos)),
+				glm::vec3(toGlm(camView.camUpDir)));
+			};
+
+		const auto render = [&](mint::CameraView& camView, mint::glFramebuffer& fbo, mint::TextureSender* ts) -> glm::mat4
 			{
-				if (hasNewWindowSize || fbo_width != fbo.m_width || fbo_height != fbo.m_height) {
-					fbo.resizeTexture(fbo_width, fbo_height);
+				if (hasNewWindowSize || render_width != fbo.m_width || render_height != fbo.m_height) {
+					fbo.resizeTexture(render_width, render_height);
 				}
+				mint::glFramebuffer& target = refining ? fbo_refine : fbo;
+				if (refining && (level_width != target.m_width || level_height != target.m_height))
+					target.resizeTexture(level_width, level_height); // only reallocates beyond its capacity
 
 				// render into custom framebuffer
-				fbo.bind();
-				glViewport(0, 0, fbo_width, fbo_height);
+				target.bind();
+				glViewport(0, 0, level_width, level_height);
 				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 				//const auto cameraModel = getModelMatrix(cameraPose);
-				view = glm::lookAt(
-					glm::vec3(toGlm(camView.eyePos)),
-					glm::vec3(toGlm(camView.lookAtPos)),
-					glm::vec3(toGlm(camView.camUpDir)));
+				view = getViewMatrix(camView);
 
 				const auto mvp = projection * view;
 
@@ -525,11 +851,68 @@ int main(int argc, char** argv)
 				glDrawElements(GL_LINE_STRIP, bboxElements.size(), GL_UNSIGNED_INT, (void*)0);
 				bbox.unbind();
 
-				fbo.unbind();
+				target.unbind();
+				if (refining) {
+					// blits color and depth of the level over the whole viewport of fbo
+					fbo.bind();
+					fbo_refine.blitTexture();
+					fbo.unbind();
+				}
 				if (ts) {
-					ts->send(fbo.m_glTextureRGBA8, fbo_width, fbo_height);
+					ts->send(fbo.m_glTextureRGBA8, render_width, render_height);
 					fbo.blitTexture(); // blit custom fbo to default framebuffer
 				}
+				return view;
+			};
+
+		// renders both eyes at once into the color regions of the stereo texture
+		const auto renderSinglePass = [&](const glm::mat4& view_left, const glm::mat4& view_right)
+			{
+				mint::glFramebuffer& fbo = textureSender.stereotextureSender.beginRenderInPlace(render_width, render_height);
+				const mint::Rect* eyes = textureSender.stereotextureSender.m_packing.color;
+
+				fbo.bind();
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				// the eyes are side by side or on top of each other, so one viewport covers both
+				const int x0 = eyes[0].x, y0 = eyes[0].y;
+				const int width = eyes[1].x + eyes[1].width - x0;
+				const int height = eyes[1].y + eyes[1].height - y0;
+				glm::vec4 eye_clip[2];
+				for (int eye = 0; eye < 2; eye++) {
+					if (has_viewport_array)
+						glViewportIndexedf(eye, (float)eyes[eye].x, (float)eyes[eye].y, (float)eyes[eye].width, (float)eyes[eye].height);
+					eye_clip[eye] = glm::vec4{
+						eyes[eye].width / (float)width,
+						eyes[eye].height / (float)height,
+						(2.0f * (eyes[eye].x - x0) + eyes[eye].width) / width - 1.0f,
+						(2.0f * (eyes[eye].y - y0) + eyes[eye].height) / height - 1.0f };
+				}
+				if (!has_viewport_array) {
+					glViewport(x0, y0, width, height);
+					for (int i = 0; i < 4; i++)
+						glEnable(GL_CLIP_DISTANCE0 + i);
+				}
+
+				const glm::mat4 mvp[2] = { projection * view_left, projection * view_right };
+
+				glUseProgram(single_pass_program);
+				glUniformMatrix4fv(single_pass_mvp_location, 2, GL_FALSE, (const GLfloat*)glm::value_ptr(mvp[0]));
+				glUniform4fv(single_pass_eye_clip_location, 2, (const GLfloat*)glm::value_ptr(eye_clip[0]));
+
+				quad.bind();
+				glDrawArraysInstanced(GL_TRIANGLES, 0, 6, 2);
+				quad.unbind();
+
+				bbox.bind();
+				glDrawElementsInstanced(GL_LINE_STRIP, bboxElements.size(), GL_UNSIGNED_INT, (void*)0, 2);
+				bbox.unbind();
+
+				if (!has_viewport_array)
+					for (int i = 0; i < 4; i++)
+						glDisable(GL_CLIP_DISTANCE0 + i);
+				// unbind() restores all viewports and keeps the interop GL state cache in sync
+				fbo.unbind();
 			};
 
 		mint::TextureSender* left_sender_ptr = nullptr;
@@ -543,14 +926,32 @@ int main(int argc, char** argv)
 			right_sender_ptr = &textureSender.righttextureSender;
 			break;
 		case TextureSenderMode::Stereo:
+			[[fallthrough]];
+		case TextureSenderMode::MultiView:
 			left_sender_ptr = nullptr;
 			right_sender_ptr = nullptr;
 			break;
 		default:
 			break;
 		}
-		render(stereoCameraView.leftEyeView, fbo_left, left_sender_ptr);
-		render(stereoCameraView.rightEyeView, fbo_right, right_sender_ptr);
+		glm::mat4 view_left, view_right;
+		if (single_pass_stereo) {
+			view_left = getViewMatrix(stereoCameraView.leftEyeView);
+			view_right = getViewMatrix(stereoCameraView.rightEyeView);
+			renderSinglePass(view_left, view_right);
+		}
+		else {
+			view_left = render(stereoCameraView.leftEyeView, fbo_left, left_sender_ptr);
+			view_right = render(stereoCameraView.rightEyeView, fbo_right, right_sender_ptr);
+		}
+
+		// cameras and timing of this frame go into the frame metadata of the stereo image
+		textureSender.stereotextureSender.setFrameCameras(toInterop(view_left), toInterop(projection), toInterop(view_right), toInterop(projection));
+		textureSender.stereotextureSender.setRenderStart(render_start_ns);
+		textureSender.stereotextureSender.setPredictionHorizon(pose_predictor.m_horizonMs);
+		textureSender.multiviewtextureSender.setViewCamera(0, toInterop(view_left), toInterop(projection));
+		textureSender.multiviewtextureSender.setViewCamera(1, toInterop(view_right), toInterop(projection));
+		textureSender.multiviewtextureSender.setRenderStart(render_start_ns);
 
 		// embedd frame id from steering in texture
 		mint::uint steering_frame_id = 0;
@@ -563,7 +964,22 @@ int main(int argc, char** argv)
 		case TextureSenderMode::All:
 			[[fallthrough]];
 		case TextureSenderMode::Stereo:
-			textureSender.stereotextureSender.send(fbo_left, fbo_right, fbo_width, fbo_height, steering_frame_id, rendering_last_frame_ms);
+			if (single_pass_stereo)
+				textureSender.stereotextureSender.sendInPlace(steering_frame_id, rendering_last_frame_ms);
+			else
+				textureSender.stereotextureSender.send(fbo_left, fbo_right, render_width, render_height, steering_frame_id, rendering_last_frame_ms);
+			frame_credits.sent(textureSender.stereotextureSender.m_metadata.frame_sequence);
+			// skip the first second of warm up. the timer result lags and is not new every frame,
+			// so only results not counted yet are taken
+			if (pack_benchmark_sec > 0.0f && textureSender.stereotextureSender.m_packer.m_gpuResults != pack_gpu_results) {
+				pack_gpu_results = textureSender.stereotextureSender.m_packer.m_gpuResults;
+				if (FpMilliseconds(current_time - program_start_time).count() > 1000.0f)
+					pack_gpu_ms.push_back(textureSender.stereotextureSender.getPackGpuMs());
+			}
+			break;
+		case TextureSenderMode::MultiView:
+			textureSender.multiviewtextureSender.send({ &fbo_left, &fbo_right }, render_width, render_height, steering_frame_id, rendering_last_frame_ms);
+			frame_credits.sent(textureSender.multiviewtextureSender.m_metadata.frame_sequence);
 			break;
 		case TextureSenderMode::Single:
 			break;
@@ -571,10 +987,41 @@ int main(int argc, char** argv)
 			break;
 		}
 
+		if (measure_frame)
+			dynamic_resolution.endFrame();
+
+		if (pack_benchmark_sec > 0.0f && FpMilliseconds(current_time - program_start_time).count() > 1000.0f * (1.0f + pack_benchmark_sec))
+			glfwSetWindowShouldClose(window, true);
+
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	if (pack_benchmark_sec > 0.0f) {
+		std::sort(pack_gpu_ms.begin(), pack_gpu_ms.end());
+		const auto pack_average = pack_gpu_ms.empty() ? 0.0f : std::accumulate(pack_gpu_ms.begin(), pack_gpu_ms.end(), 0.0f) / pack_gpu_ms.size();
+		const auto pack_median = pack_gpu_ms.empty() ? 0.0f : pack_gpu_ms[pack_gpu_ms.size() / 2];
+		// single pass rendering needs rgba8 color, which is lossless
+		const auto& packing = textureSender.stereotextureSender.m_packing;
+		const auto color_psnr = single_pass_stereo
+			? std::numeric_limits<float>::infinity()
+			: textureSender.stereotextureSender.measureColorPsnr(fbo_left.m_glTextureRGBA8);
+		const std::string result = "# Path,ColorCopy,ColorEncoding,Width,Height,PackedBytes,Frames,AverageGpuMS,MedianGpuMS,ColorPSNR\n"
+			+ std::string(textureSender.stereotextureSender.m_packer.m_useCompute ? "compute" : "fragment") + ","
+			+ std::to_string(textureSender.stereotextureSender.m_packer.m_copyColor ? 1 : 0) + ","
+			+ std::to_string(static_cast<int>(packing_format.color_encoding)) + ","
+			+ std::to_string(fbo_width) + "," + std::to_string(fbo_height) + ","
+			+ std::to_string(packing.image_width * packing.image_height * 4) + ","
+			+ std::to_string(pack_gpu_ms.size()) + ","
+			+ std::to_string(pack_average) + "," + std::to_string(pack_median) + ","
+			+ std::to_string(color_psnr) + "\n";
+		std::cout << "PACKING:\n" << result;
+		if (!pack_benchmark_file.empty()) {
+			std::ofstream out(pack_benchmark_file);
+			out << result;
+		}
+	}
+
 	data_receiver.stop();
 	//cameraProjectionReceiver.stop();
 	//stereoCameraViewReceiver_relative.stop();
@@ -582,10 +1029,13 @@ int main(int argc, char** argv)
 
 	fbo_left.destroy();
 	fbo_right.destroy();
+	fbo_refine.destroy();
+	dynamic_resolution.destroy();
 	textureSender.destroy();
 
 	quad.destroy();
 	bbox.destroy();
+	glDeleteProgram(single_pass_program);
 
 	std::cout << "mint rendering exit \naverage frame ms: " << fps_average() << std::endl;
 
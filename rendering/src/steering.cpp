@@ -13,6 +13,7 @@
 #include <thread>
 #include <ctime>
 #include <fstream>
+#include <cstddef>
 
 #include <CLI/CLI.hpp>
 
@@ -24,6 +25,12 @@ glm::vec4 toGlm(const mint::vec4& v) {
 mint::vec4 toInterop(const glm::vec3& v) {
 	return mint::vec4{ v.x, v.y, v.z, 0.0f };
 }
+mint::vec4 toInterop(const glm::vec4& v) {
+	return mint::vec4{ v.x, v.y, v.z, v.w };
+}
+mint::mat4 toInterop(const glm::mat4& m) {
+	return mint::mat4{ toInterop(m[0]), toInterop(m[1]), toInterop(m[2]), toInterop(m[3]) };
+}
 glm::mat4 toGlm(const mint::mat4& m) {
 	return glm::mat4{
 		toGlm(m.data[0]),
@@ -38,10 +45,15 @@ static void glfw_error_callback(int error, const char* description)
 	std::cout << "GLFW Error " << error << ": " << description << std::endl;
 }
 
+// space pauses the camera orbit, a resting camera lets a progressive renderer refine its frames
+static bool camera_orbit = true;
+
 static void glfw_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GLFW_TRUE);
+	if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
+		camera_orbit = !camera_orbit;
 }
 
 void APIENTRY opengl_debug_message_callback(
@@ -142,6 +154,7 @@ R"(
 	//in int gl_VertexID;
 
 	uniform sampler2D texture_in;
+	uniform int texture_flip_y;
 
 	uniform int latency_measure_active;
 	uniform int latency_measure_current_frame_id;
@@ -152,6 +165,13 @@ R"(
 	  uvec4 data[]; // x = render loop frame id, y = incoming texture frame id
 	} ssbo_data;
 
+	// the displayed frame, read back a few frames later and acknowledged to the renderer
+	uniform int frame_ack_slot;
+	layout (std430, binding=3) buffer FrameAckBlock
+	{
+	  uvec4 frame_acks[]; // x = frame_sequence, y = steering_frame_id, w = 1 for a stereo image with a header
+	};
+
 	const vec4 unitQuad[4] =
 	vec4[](
 		vec4(-1.0f, 1.0f, 0.0f, 1.0f),
@@ -160,22 +180,33 @@ R"(
 		vec4( 1.0f,-1.0f, 0.0f, 1.0f)
 	);
 	
+	// word of the mint::FrameMetadata in the header rows of the stereo image
+	uint headerWord(int index) {
+		ivec2 size = textureSize(texture_in, 0);
+		ivec2 coord = ivec2(index % size.x, index / size.x);
+		if (texture_flip_y > 0)
+			coord.y = size.y - 1 - coord.y;
+		return packUnorm4x8(texelFetch(texture_in, coord, 0));
+	}
+
 	void main()
 	{
 	    gl_Position = unitQuad[gl_VertexID];
 
 		if(gl_VertexID == 0 && latency_measure_active > 0) {
-			// reverses: FragColor = unpackUnorm4x8(uint(meta_data))
-			vec4 steering_id_raw = texelFetch(texture_in, ivec2(0,0), 0);
-			vec4 renderer_fps_raw = texelFetch(texture_in, ivec2(1,0), 0);
-			uint texture_frame_id = packUnorm4x8(steering_id_raw);
-			uint texture_renderer_fps = packUnorm4x8(renderer_fps_raw);
+			uint texture_frame_id = headerWord(3); // steering_frame_id
+			uint texture_renderer_fps = headerWord(4); // user_data
 			ssbo_data.data[latency_measure_current_index] = uvec4(
 				latency_measure_current_frame_id,
 				texture_frame_id,
 				texture_renderer_fps,
 				0);
 		}
+
+		if(gl_VertexID == 0) {
+			bool has_header = headerWord(0) == 0x746e696du; // mint::FrameMetadata::Magic
+			frame_acks[frame_ack_slot] = uvec4(headerWord(5) /* frame_sequence */, headerWord(3), 0, has_header ? 1 : 0);
+		}
 	}
 )";
 
@@ -188,11 +219,108 @@ R"(
 	out vec4 FragColor;
 
 	uniform sampler2D texture_in;
+	uniform int texture_flip_y;
 	uniform ivec2 texture_size;
 
 	void main()
 	{
-		FragColor = texture(texture_in, vec2(gl_FragCoord.xy) / vec2(texture_size.xy));
+		vec2 uv = vec2(gl_FragCoord.xy) / vec2(texture_size.xy);
+		if (texture_flip_y > 0)
+			uv.y = 1.0 - uv.y;
+		FragColor = texture(texture_in, uv);
+	}
+)";
+
+// reprojection: a grid mesh over an eye of the received frame, each vertex moved from the
+// camera the frame was rendered with to the current camera by its depth. triangles stretch over
+// disocclusions, which fills the holes with the colors of their borders
+const char* reproject_vertex_shader_source =
+R"(
+	#version 430 core
+
+	uniform sampler2D texture_in; // packed image, its header rows hold the cameras of the frame
+	uniform int texture_flip_y;
+	uniform sampler2D color_in; // unpacked eye
+	uniform sampler2D depth_in;
+	uniform int has_depth; // without depth the frame is only rotated, as if it was infinitely far away
+	uniform ivec2 grid_size; // vertices per row and column
+	uniform mat4 frame_inverse_view_projection; // of the camera the eye was rendered with
+	uniform mat4 current_view_projection;
+
+	uniform int latency_measure_active;
+	uniform int latency_measure_current_frame_id;
+	uniform int latency_measure_current_index;
+
+	layout (std430, binding=2) buffer LatencySsboDataBlock
+	{ 
+	  uvec4 data[]; // x = render loop frame id, y = incoming texture frame id
+	} ssbo_data;
+
+	// the displayed frame, read back a few frames later and acknowledged to the renderer
+	uniform int frame_ack_slot;
+	layout (std430, binding=3) buffer FrameAckBlock
+	{
+	  uvec4 frame_acks[]; // x = frame_sequence, y = steering_frame_id, w = 1 for a stereo image with a header
+	};
+
+	out vec2 color_uv;
+
+	// word of the mint::FrameMetadata in the header rows of the stereo image
+	uint headerWord(int index) {
+		ivec2 size = textureSize(texture_in, 0);
+		ivec2 coord = ivec2(index % size.x, index / size.x);
+		if (texture_flip_y > 0)
+			coord.y = size.y - 1 - coord.y;
+		return packUnorm4x8(texelFetch(texture_in, coord, 0));
+	}
+
+	void main()
+	{
+		ivec2 grid_coord = ivec2(gl_VertexID % grid_size.x, gl_VertexID / grid_size.x);
+		vec2 uv = vec2(grid_coord) / vec2(grid_size - 1);
+
+		float depth = 1.0;
+		if (has_depth > 0) {
+			ivec2 depth_size = textureSize(depth_in, 0);
+			depth = texelFetch(depth_in, ivec2(round(uv * vec2(depth_size - 1))), 0).r;
+		}
+
+		vec4 world = frame_inverse_view_projection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+		if (has_depth == 0)
+			world.w = 0.0; // direction only
+		gl_Position = current_view_projection * world;
+		color_uv = uv;
+
+		if(gl_VertexID == 0 && latency_measure_active > 0) {
+			uint texture_frame_id = headerWord(3); // steering_frame_id
+			uint texture_renderer_fps = headerWord(4); // user_data
+			ssbo_data.data[latency_measure_current_index] = uvec4(
+				latency_measure_current_frame_id,
+				texture_frame_id,
+				texture_renderer_fps,
+				0);
+		}
+
+		if(gl_VertexID == 0) {
+			bool has_header = headerWord(0) == 0x746e696du; // mint::FrameMetadata::Magic
+			frame_acks[frame_ack_slot] = uvec4(headerWord(5) /* frame_sequence */, headerWord(3), 0, has_header ? 1 : 0);
+		}
+	}
+)";
+
+const char* reproject_fragment_shader_source =
+R"(
+	#version 430 core
+
+	in vec2 color_uv;
+
+	out vec4 FragColor;
+
+	uniform sampler2D color_in;
+
+	void main()
+	{
+		FragColor = texture(color_in, color_uv);
 	}
 )";
 
@@ -208,10 +336,13 @@ int main(int argc, char** argv)
 		->transform(CLI::CheckedTransformer(map_zmq, CLI::ignore_case));
 
 	mint::ImageProtocol spout_protocol = mint::ImageProtocol::GPU;
-	std::map<std::string, mint::ImageProtocol> map_spout = { {"gpu", mint::ImageProtocol::GPU}, {"cpu", mint::ImageProtocol::CPU}, {"memshare", mint::ImageProtocol::MemShare} };
+	std::map<std::string, mint::ImageProtocol> map_spout = { {"gpu", mint::ImageProtocol::GPU}, {"cpu", mint::ImageProtocol::CPU}, {"memshare", mint::ImageProtocol::MemShare}, {"network", mint::ImageProtocol::Network} };
 	app.add_option("--spout", spout_protocol, "Spout protocol to use for texture sharing. Options: ram (shared memory), vram")
 		->transform(CLI::CheckedTransformer(map_spout, CLI::ignore_case));
 
+	mint::NetworkImageSettings network_image;
+	app.add_option("--image-address", network_image.address, "Address of the rendering the network image transport (--spout network) connects to, default tcp://localhost:12347");
+
 	std::filesystem::path latency_measure_output_file = "";
 	app.add_option("-f,--latency-file", latency_measure_output_file, "Output file for latency measurements");
 
@@ -227,10 +358,26 @@ int main(int argc, char** argv)
 	bool vsync = false;
 	app.add_flag("--vsync", vsync, "Whether to activate vsync for this process");
 
+	bool reproject = false;
+	app.add_flag("--reproject", reproject, "Warp the latest received stereo image to the current cameras using its depth, shows the eyes side by side");
+
+	int reproject_grid_step = 4;
+	app.add_option("--reproject-grid", reproject_grid_step, "Pixels between the vertices of the reprojection mesh");
+
+	bool multiview = false;
+	app.add_flag("--multiview", multiview, "Receive the multi view atlas of rendering --texture-send multiview instead of the stereo image, needs --reproject");
+	unsigned int first_view = 0;
+	app.add_option("--first-view", first_view, "View of the multi view atlas shown as the left eye, the next one is the right eye");
+
 	CLI11_PARSE(app, argc, argv);
 	// cli data available only after parsing!
 	auto latency_measure_duration_ms = latency_measure_duration_sec * 1000.0f;
 	auto latency_measure_delay_until_start_ms = latency_measure_delay_until_start_sec * 1000.0f;
+	reproject_grid_step = (reproject_grid_step > 0) ? reproject_grid_step : 1;
+	if (multiview && !reproject) {
+		std::cout << "steering: the multi view atlas is only unpacked for reprojection, reprojecting" << std::endl;
+		reproject = true;
+	}
 	if (image_size_used->count() > 0)
 		std::cout << "Texture Size: " << image_size[0] << "x" << image_size[1] << std::endl;
 
@@ -287,12 +434,13 @@ int main(int argc, char** argv)
 		}
 		};
 
+	// the reprojection shaders take the same texture and latency measurement uniforms
 	vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex_shader, 1, &vertex_shader_source, NULL);
+	glShaderSource(vertex_shader, 1, reproject ? &reproject_vertex_shader_source : &vertex_shader_source, NULL);
 	glCompileShader(vertex_shader);
 	check_shader_compilation("Vertex", vertex_shader);
 	fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment_shader, 1, &fragment_shader_source, NULL);
+	glShaderSource(fragment_shader, 1, reproject ? &reproject_fragment_shader_source : &fragment_shader_source, NULL);
 	glCompileShader(fragment_shader);
 	check_shader_compilation("Fragment", fragment_shader);
 	program = glCreateProgram();
@@ -346,11 +494,55 @@ int main(int argc, char** argv)
 		glUnmapNamedBuffer(latency_ssbo);
 		};
 
+	// ring of the frames the display shaders showed, persistently mapped. a slot is read once the fence
+	// of its frame passed, which is a few frames later, so acknowledging never waits for the gpu
+	constexpr mint::uint frame_ack_slots = 4;
+	const GLsizeiptr frame_ack_size = frame_ack_slots * sizeof(glm::uvec4);
+	const GLbitfield frame_ack_access = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLuint frame_ack_ssbo = 0;
+	glCreateBuffers(1, &frame_ack_ssbo);
+	glNamedBufferStorage(frame_ack_ssbo, frame_ack_size, nullptr, frame_ack_access);
+	auto* frame_acks = static_cast<glm::uvec4*>(glMapNamedBufferRange(frame_ack_ssbo, 0, frame_ack_size, frame_ack_access));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, frame_ack_ssbo);
+	GLsync frame_ack_fences[frame_ack_slots] = { nullptr };
+	mint::uint acknowledged_frame = 0;
+	mint::uint dropped_frames = 0; // frame sequences skipped between displayed frames
+	bool has_new_acknowledgement = false;
+
+	// true once the slot is free, reads it if its frame showed a new stereo image
+	auto read_frame_ack = [&](const mint::uint slot, const bool wait) -> bool {
+		if (!frame_ack_fences[slot])
+			return true;
+		const GLenum status = glClientWaitSync(frame_ack_fences[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+		if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+			return false;
+		glDeleteSync(frame_ack_fences[slot]);
+		frame_ack_fences[slot] = nullptr;
+
+		// acknowledgements only move forward, a frame shown before the last acknowledged one changes nothing
+		const glm::uvec4 ack = frame_acks[slot];
+		if (ack.w == 0 || (acknowledged_frame && ack.x <= acknowledged_frame))
+			return true;
+		if (acknowledged_frame && ack.x > acknowledged_frame + 1)
+			dropped_frames += ack.x - acknowledged_frame - 1;
+		acknowledged_frame = ack.x;
+		has_new_acknowledgement = true;
+		return true;
+		};
+
 	GLuint uniform_texture_location = glGetUniformLocation(program, "texture_in"); // sampler2D
 	GLuint uniform_texture_size_location = glGetUniformLocation(program, "texture_size"); // ivec2
+	GLuint uniform_texture_flip_y_location = glGetUniformLocation(program, "texture_flip_y"); // int
 	GLuint uniform_latency_measure_active = glGetUniformLocation(program, "latency_measure_active"); // int 
 	GLuint uniform_latency_measure_frame_id = glGetUniformLocation(program, "latency_measure_current_frame_id"); // int 
 	GLuint uniform_latency_measure_index = glGetUniformLocation(program, "latency_measure_current_index"); // int 
+	GLuint uniform_frame_ack_slot_location = glGetUniformLocation(program, "frame_ack_slot"); // int
+	GLuint uniform_color_in_location = glGetUniformLocation(program, "color_in"); // sampler2D, reprojection only
+	GLuint uniform_depth_in_location = glGetUniformLocation(program, "depth_in"); // sampler2D
+	GLuint uniform_has_depth_location = glGetUniformLocation(program, "has_depth"); // int
+	GLuint uniform_grid_size_location = glGetUniformLocation(program, "grid_size"); // ivec2
+	GLuint uniform_frame_inverse_view_projection_location = glGetUniformLocation(program, "frame_inverse_view_projection"); // mat4
+	GLuint uniform_current_view_projection_location = glGetUniformLocation(program, "current_view_projection"); // mat4
 
 	bool latency_measure_active = false;
 
@@ -361,24 +553,50 @@ int main(int argc, char** argv)
 	//registerVertexAttributes();
 	quad.unbind();
 
+	// triangles of the reprojection grid, rebuilt when the grid size changes
+	RenderVertices reproject_mesh;
+	reproject_mesh.init(quadVertices);
+	glm::ivec2 reproject_grid_size{ 0, 0 };
+	GLsizei reproject_index_count = 0;
+
+	mint::setNetworkImageSettings(network_image);
 	mint::init(mint::Role::Steering, zmq_protocol, spout_protocol);
 
 	mint::glFramebuffer fbo;
 	fbo.init();
 
+	// we sample the received textures directly, no need for the receivers to blit them anywhere
 	mint::TextureReceiver texture_receiver_stereo;
-	texture_receiver_stereo.init(mint::ImageType::SingleStereo);
+	// reprojection needs the stereo image split into color and depth, which the unpacker receives itself
+	mint::StereoTextureReceiver stereo_unpacker;
+	mint::DepthPicker depth_picker;
+	bool mouse_was_down = false;
+	// cameras the eyes were last warped to, picks unproject the depth of the display with them
+	bool displayed_eyes[2] = { false, false };
+	glm::mat4 displayed_views[2];
+	glm::mat4 displayed_projection;
+	mint::uint displayed_frame_sequence = 0;
+	if (reproject) {
+		stereo_unpacker.init("", multiview ? mint::ImageType::MultiView : mint::ImageType::SingleStereo);
+		stereo_unpacker.m_firstView = first_view;
+		// the cameras of the unpacked frame are needed on the CPU
+		stereo_unpacker.m_syncHeader = true;
+		depth_picker.init();
+	}
+	else
+		texture_receiver_stereo.init(mint::ImageType::SingleStereo, "", mint::ReceiveMode::Texture);
 
 	mint::TextureReceiver texture_receiver_left;
-	texture_receiver_left.init(mint::ImageType::LeftEye);
+	texture_receiver_left.init(mint::ImageType::LeftEye, "", mint::ReceiveMode::Texture);
 	mint::TextureReceiver texture_receiver_right;
-	texture_receiver_right.init(mint::ImageType::RightEye);
+	texture_receiver_right.init(mint::ImageType::RightEye, "", mint::ReceiveMode::Texture);
 
 	mint::DataSender data_sender;
 	data_sender.start();
 
 	auto cameraProjection = mint::CameraProjection(); // "CameraProjection"
 	auto stereoCameraView = mint::StereoCameraViewRelative(); // "StereoCameraViewRelative"
+	data_sender.stampSendTime(mint::to_data_name(stereoCameraView)); // rendering predicts the camera from its send times
 
 	mint::DataReceiver data_receiver;
 	data_receiver.start();
@@ -457,7 +675,20 @@ int main(int argc, char** argv)
 		if (frame_timing_index == 0) {
 			float frame_ms = fps_average();
 			std::string fps_info = " | " + std::to_string(frame_ms) + " ms/f | " + std::to_string(1000.0f / frame_ms) + " fps";
-			std::string title = window_name + fps_info;
+			std::string gl_info = " | " + std::to_string(mint::getGlStateStatistics().queries_saved) + " GL queries saved/f";
+			// the renderer may scale its resolution down, the frame is stretched to the window regardless
+			std::string scale_info = reproject ? " | render scale " + std::to_string(stereo_unpacker.m_metadata.render_scale) : "";
+			// a progressive renderer refines a resting camera, the latest frame holds the best level it reached
+			const auto& metadata = stereo_unpacker.m_metadata;
+			std::string level_info = (reproject && metadata.refinement_levels > 0)
+				? " | level " + std::to_string(metadata.refinement_level + 1) + "/" + std::to_string(metadata.refinement_levels)
+				: "";
+			// a predicting renderer drew the cameras ahead of the newest pose it had
+			std::string prediction_info = (reproject && metadata.prediction_ms > 0.0f)
+				? " | predicted " + std::to_string(metadata.prediction_ms) + " ms"
+				: "";
+			std::string drop_info = acknowledged_frame ? " | " + std::to_string(dropped_frames) + " frames dropped" : "";
+			std::string title = window_name + fps_info + gl_info + scale_info + level_info + prediction_info + drop_info;
 			glfwSetWindowTitle(window, title.c_str());
 		}
 		frame_timing_index = (frame_timing_index + 1) % frame_durations.size();
@@ -468,6 +699,7 @@ int main(int argc, char** argv)
 		// default framebuffer
 		glViewport(0, 0, fbo_width, fbo_height);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		mint::syncGlState(); // once per frame, interop works from cached bindings afterwards
 
 		cameraProjection.fieldOfViewY_rad = fovy;
 		cameraProjection.nearClipPlane = near_p;
@@ -515,7 +747,8 @@ int main(int argc, char** argv)
 				return t2 * r * t1;
 			};
 
-		defaultCameraView.eyePos = toInterop(glm::vec3(rotate_around(glfwGetTime() * 0.001f, glm::vec3(toGlm(defaultCameraView.lookAtPos)), glm::vec3(toGlm(defaultCameraView.camUpDir))) * toGlm(defaultCameraView.eyePos)));
+		if (camera_orbit)
+			defaultCameraView.eyePos = toInterop(glm::vec3(rotate_around(glfwGetTime() * 0.001f, glm::vec3(toGlm(defaultCameraView.lookAtPos)), glm::vec3(toGlm(defaultCameraView.camUpDir))) * toGlm(defaultCameraView.eyePos)));
 
 		stereoCameraView.leftEyeView = defaultCameraView;
 		stereoCameraView.leftEyeView.eyePos.w = glm::uintBitsToFloat(frame_id);
@@ -526,15 +759,51 @@ int main(int argc, char** argv)
 		data_sender.send(stereoCameraView);
 		data_sender.send(cameraProjection);
 
-		bool has_stereo_image = texture_receiver_stereo.receive();
+		bool has_stereo_image = reproject ? stereo_unpacker.receive() : texture_receiver_stereo.receive();
 		bool has_left_image = texture_receiver_left.receive();
 		bool has_right_image = texture_receiver_right.receive();
 
-		auto texture_handle = has_stereo_image
-			? (texture_receiver_stereo.m_texture_handle)
+		// the unpacked textures keep the latest frame, it is warped again when no new one arrived
+		const bool has_unpacked_image = reproject && stereo_unpacker.m_packing.width > 0;
+		has_stereo_image |= has_unpacked_image;
+
+		auto& texture_receiver = has_stereo_image
+			? (reproject ? stereo_unpacker.m_receiver : texture_receiver_stereo)
 			: (has_left_image
-				? texture_receiver_left.m_texture_handle
-				: has_right_image ? texture_receiver_right.m_texture_handle : 0);
+				? texture_receiver_left
+				: texture_receiver_right);
+		auto texture_handle = (has_stereo_image || has_left_image || has_right_image)
+			? texture_receiver.m_texture_handle
+			: 0;
+
+		// left click picks the world position under the cursor from the depth of the last displayed frame.
+		// the display shows each eye stretched to its half of the window, warped to the current camera,
+		// so the pick reads the depth of the display, which the warp wrote, not the depth of the frame
+		const bool mouse_down = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		if (reproject && has_unpacked_image && mouse_down && !mouse_was_down) {
+			double cursor_x = 0.0, cursor_y = 0.0;
+			int window_width = 1, window_height = 1;
+			glfwGetCursorPos(window, &cursor_x, &cursor_y);
+			glfwGetWindowSize(window, &window_width, &window_height);
+			const double half_x = glm::clamp(cursor_x / window_width, 0.0, 1.0) * 2.0;
+			const mint::uint eye = (half_x >= 1.0) ? 1 : 0;
+			const mint::Rect viewport{ eye * static_cast<mint::uint>(fbo.m_width / 2), 0,
+				static_cast<mint::uint>(fbo.m_width / 2), static_cast<mint::uint>(fbo.m_height) };
+			const auto x = static_cast<mint::uint>(glm::clamp(half_x - eye, 0.0, 1.0) * (viewport.width - 1));
+			const auto y = static_cast<mint::uint>(glm::clamp(1.0 - cursor_y / window_height, 0.0, 1.0) * (viewport.height - 1));
+			if (displayed_eyes[eye])
+				depth_picker.request(fbo, viewport, eye, x, y, toInterop(displayed_views[eye]), toInterop(displayed_projection),
+					2, displayed_frame_sequence);
+		}
+		mouse_was_down = mouse_down;
+		for (const auto& pick : depth_picker.poll()) {
+			if (pick.hit)
+				std::cout << "pick (" << pick.x << ", " << pick.y << "): world ("
+					<< pick.world.x << ", " << pick.world.y << ", " << pick.world.z << ")"
+					<< " frame " << pick.frame_sequence << std::endl;
+			else
+				std::cout << "pick (" << pick.x << ", " << pick.y << "): nothing" << std::endl;
+		}
 
 		if (!texture_handle)
 			std::cout << "mint steering: no texture(s) received" << std::endl;
@@ -645,17 +914,97 @@ int main(int argc, char** argv)
 		glUniform1i(uniform_latency_measure_active, latency_measure_active ? 1 : 0);
 		glUniform1i(uniform_latency_measure_frame_id, static_cast<int>(frame_id));
 		glUniform1i(uniform_latency_measure_index, static_cast<int>(latency_ssbo_index));
+
+		// oldest slot first, so drops are counted in order. the slot of this frame was used frame_ack_slots ago,
+		// it is waited for, the newer ones are read as far as the gpu finished them
+		const mint::uint frame_ack_slot = frame_id % frame_ack_slots;
+		for (mint::uint i = 0; i < frame_ack_slots; i++)
+			if (!read_frame_ack((frame_ack_slot + i) % frame_ack_slots, i == 0))
+				break;
+		if (frame_ack_fences[frame_ack_slot]) {
+			// the wait failed, the acknowledgement of that frame is lost but its fence must not leak
+			glDeleteSync(frame_ack_fences[frame_ack_slot]);
+			frame_ack_fences[frame_ack_slot] = nullptr;
+		}
+		frame_acks[frame_ack_slot] = glm::uvec4(0); // stays invalid when nothing is drawn
+		glUniform1i(uniform_frame_ack_slot_location, static_cast<int>(frame_ack_slot));
 		glUniform2i(uniform_texture_size_location, fbo_width, fbo_height);
+		glUniform1i(uniform_texture_flip_y_location, texture_receiver.m_flip_y ? 1 : 0);
 
 		//std::this_thread::sleep_for(1s);
 
-		quad.bind();
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		quad.unbind();
+		if (reproject) {
+			if (has_unpacked_image) {
+				const auto& packing = stereo_unpacker.m_packing;
+				const glm::ivec2 grid_size{
+					(static_cast<int>(packing.width) + reproject_grid_step - 1) / reproject_grid_step + 1,
+					(static_cast<int>(packing.height) + reproject_grid_step - 1) / reproject_grid_step + 1 };
+				if (grid_size.x != reproject_grid_size.x || grid_size.y != reproject_grid_size.y) {
+					std::vector<unsigned int> elements;
+					elements.reserve((grid_size.x - 1) * (grid_size.y - 1) * 6);
+					for (int y = 0; y + 1 < grid_size.y; y++)
+						for (int x = 0; x + 1 < grid_size.x; x++) {
+							const unsigned int i = y * grid_size.x + x;
+							const unsigned int w = grid_size.x;
+							for (unsigned int e : { i, i + 1, i + w, i + 1, i + w + 1, i + w })
+								elements.push_back(e);
+						}
+					reproject_mesh.setElements(elements);
+					reproject_grid_size = grid_size;
+					reproject_index_count = static_cast<GLsizei>(elements.size());
+				}
+
+				glUniform1i(uniform_color_in_location, 1);
+				glUniform1i(uniform_depth_in_location, 2);
+				glUniform1i(uniform_has_depth_location, packing.hasDepth() ? 1 : 0);
+				glUniform2i(uniform_grid_size_location, grid_size.x, grid_size.y);
+				const auto current_projection = glm::perspective(fovy, aspect_ratio, near_p, far_p);
+
+				// left eye on the left half of the window, right eye on the right half
+				reproject_mesh.bind();
+				for (mint::uint e = 0; e < 2; e++) {
+					displayed_eyes[e] = stereo_unpacker.hasEye(e);
+					if (!displayed_eyes[e])
+						continue;
+					const auto& eye = (e == 0) ? stereoCameraView.leftEyeView : stereoCameraView.rightEyeView;
+					const auto current_view = glm::lookAt(glm::vec3(toGlm(eye.eyePos)), glm::vec3(toGlm(eye.lookAtPos)), glm::vec3(toGlm(eye.camUpDir)));
+					const auto current_view_projection = current_projection * current_view;
+					const auto frame_view = stereo_unpacker.eyeView(e);
+					const auto frame_inverse_view_projection = glm::inverse(toGlm(frame_view.projection) * toGlm(frame_view.view));
+
+					glActiveTexture(GL_TEXTURE1);
+					glBindTexture(GL_TEXTURE_2D, stereo_unpacker.m_colorTextures[e]);
+					glActiveTexture(GL_TEXTURE2);
+					glBindTexture(GL_TEXTURE_2D, stereo_unpacker.m_depthTextures[e]);
+					glUniformMatrix4fv(uniform_frame_inverse_view_projection_location, 1, GL_FALSE, glm::value_ptr(frame_inverse_view_projection));
+					glUniformMatrix4fv(uniform_current_view_projection_location, 1, GL_FALSE, glm::value_ptr(current_view_projection));
+
+					glViewport(e * (fbo_width / 2), 0, fbo_width / 2, fbo_height);
+					glDrawElements(GL_TRIANGLES, reproject_index_count, GL_UNSIGNED_INT, nullptr);
+					displayed_views[e] = current_view;
+				}
+				displayed_projection = current_projection;
+				displayed_frame_sequence = stereo_unpacker.m_metadata.frame_sequence;
+				reproject_mesh.unbind();
+				glActiveTexture(GL_TEXTURE0);
+			}
+		}
+		else {
+			quad.bind();
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			quad.unbind();
+		}
 
 		fbo.unbind();
 		fbo.blitTexture();
 
+		glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+		frame_ack_fences[frame_ack_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		if (has_new_acknowledgement) {
+			data_sender.send(acknowledged_frame, "mintframeack", std::pair{ std::string("dropped"), std::to_string(dropped_frames) });
+			has_new_acknowledgement = false;
+		}
+
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
@@ -664,12 +1013,21 @@ int main(int argc, char** argv)
 	data_receiver.stop();
 	close_sender.stop();
 
+	for (auto& fence : frame_ack_fences)
+		if (fence)
+			glDeleteSync(fence);
+	glUnmapNamedBuffer(frame_ack_ssbo);
+	glDeleteBuffers(1, &frame_ack_ssbo);
+
 	fbo.destroy();
 	texture_receiver_stereo.destroy();
+	depth_picker.destroy();
+	stereo_unpacker.destroy();
 	texture_receiver_left.destroy();
 	texture_receiver_right.destroy();
 
 	quad.destroy();
+	reproject_mesh.destroy();
 
 	std::cout << "mint steering exit \naverage frame ms: " << fps_average() << std::endl;
 